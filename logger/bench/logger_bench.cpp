@@ -0,0 +1,368 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "logger.hpp"
+
+// Пропускная способность и задержка Logger::log при 1..N потоках для разных
+// наборов фильтров, форматтеров и обработчиков:
+//   logger_bench [--threads 8] [--records 200000] [--out result.json]
+//                [--baseline baseline.json] [--tolerance 0.1]
+// Задержка - время одного вызова log() (вместе с чтением часов, ~20 нс).
+// Результат - JSON, по объекту на строку; с --baseline сценарии сравниваются
+// с сохранённым прогоном, код возврата 1 - пропускная способность упала или
+// p99 вырос больше чем на tolerance
+
+// Гистограмма в духе HDR: значения до 2^SubBits хранятся точно, дальше на
+// каждую степень двойки приходится 2^SubBits корзин (погрешность ~3%)
+class LatencyHistogram {
+private:
+    static constexpr int SubBits = 5;
+    static constexpr std::uint64_t SubCount = 1u << SubBits;
+    static constexpr int Exponents = 64 - SubBits;
+    std::vector<std::uint64_t> counts_ = std::vector<std::uint64_t>((Exponents + 1) * SubCount);
+    std::uint64_t total_ = 0;
+    std::uint64_t max_ = 0;
+
+    static std::size_t bucketOf(std::uint64_t value) {
+        if (value < SubCount) {
+            return static_cast<std::size_t>(value);
+        }
+        // value >> shift лежит в [SubCount, 2 * SubCount): старший бит неявный
+        int shift = 63 - __builtin_clzll(value) - SubBits;
+        std::uint64_t mantissa = (value >> shift) - SubCount;
+        return static_cast<std::size_t>(shift + 1) * SubCount + static_cast<std::size_t>(mantissa);
+    }
+
+public:
+    // Наибольшее значение, попадающее в корзину
+    static std::uint64_t upperBound(std::size_t bucket) {
+        if (bucket < SubCount) {
+            return bucket;
+        }
+        std::size_t shift = bucket / SubCount - 1;
+        std::uint64_t lower = (SubCount + bucket % SubCount) << shift;
+        return lower + (std::uint64_t(1) << shift) - 1;
+    }
+
+    void record(std::uint64_t value) {
+        std::size_t bucket = bucketOf(value);
+        if (bucket >= counts_.size()) {
+            bucket = counts_.size() - 1;
+        }
+        ++counts_[bucket];
+        ++total_;
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    std::uint64_t percentile(double fraction) const {
+        std::uint64_t target = static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(total_)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            seen += counts_[i];
+            if (seen >= target && seen > 0) {
+                return std::min(upperBound(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    std::uint64_t max() const {
+        return max_;
+    }
+
+    // Непустые корзины: [[верхняя граница нс, число], ...]
+    void appendJson(std::string& out) const {
+        out += '[';
+        bool first = true;
+        for (std::size_t i = 0; i < counts_.size(); ++i) {
+            if (counts_[i] == 0) {
+                continue;
+            }
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            out += '[' + std::to_string(upperBound(i)) + ',' + std::to_string(counts_[i]) + ']';
+        }
+        out += ']';
+    }
+};
+
+// Обработчик без вывода: измеряется только сам Logger
+class NullHandler : public ILogHandler {
+private:
+    std::atomic<std::uint64_t> records_{0};
+public:
+    void handle(LogLevel log_level, const std::string& text) override {
+        records_.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+struct Scenario {
+    std::string name;
+    std::function<void(Logger&, const std::string& file)> setup;
+    LogLevel level = LogLevel::INFO; // уровень записей сценария
+    bool async = false;
+};
+
+struct Result {
+    std::string scenario;
+    int threads = 0;
+    std::uint64_t records = 0;
+    double seconds = 0.0;
+    double throughput = 0.0;
+    LatencyHistogram latency;
+};
+
+static std::vector<std::string> makeMessages() {
+    std::vector<std::string> messages;
+    for (int i = 0; i < 64; ++i) {
+        messages.push_back("request " + std::to_string(1000 + i * 37) + " handled by worker " +
+                           std::to_string(i % 8) + " in " + std::to_string(40 + i) + " us, status=200");
+    }
+    return messages;
+}
+
+static Result runScenario(const Scenario& scenario, int threads, std::size_t records_per_thread,
+                          const std::string& file, const std::vector<std::string>& messages) {
+    std::filesystem::remove(file);
+    Result result;
+    result.scenario = scenario.name;
+    result.threads = threads;
+    result.records = records_per_thread * static_cast<std::size_t>(threads);
+    std::vector<LatencyHistogram> histograms(static_cast<std::size_t>(threads));
+    {
+        Logger logger;
+        scenario.setup(logger, file);
+        if (scenario.async) {
+            logger.startAsync(65536);
+        }
+        std::atomic<int> ready{0};
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                LatencyHistogram& histogram = histograms[static_cast<std::size_t>(t)];
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                for (std::size_t i = 0; i < records_per_thread; ++i) {
+                    const std::string& message = messages[(i + static_cast<std::size_t>(t)) % messages.size()];
+                    auto start = std::chrono::steady_clock::now();
+                    LOG_AT(logger, scenario.level, message);
+                    auto elapsed = std::chrono::steady_clock::now() - start;
+                    histogram.record(static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+                }
+            });
+        }
+        while (ready.load() < threads) {
+            std::this_thread::yield();
+        }
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        logger.flush(); // в асинхронном режиме ждём, пока всё будет записано
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    std::filesystem::remove(file);
+    std::filesystem::remove(file + ".idx");
+    for (const auto& histogram : histograms) {
+        result.latency.merge(histogram);
+    }
+    result.throughput = static_cast<double>(result.records) / result.seconds;
+    return result;
+}
+
+static std::string toJson(const Result& result) {
+    char numbers[256];
+    std::snprintf(numbers, sizeof(numbers),
+                  "\"records\":%llu,\"seconds\":%.6f,\"throughput\":%.1f,"
+                  "\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,\"max_ns\":%llu",
+                  static_cast<unsigned long long>(result.records), result.seconds, result.throughput,
+                  static_cast<unsigned long long>(result.latency.percentile(0.50)),
+                  static_cast<unsigned long long>(result.latency.percentile(0.90)),
+                  static_cast<unsigned long long>(result.latency.percentile(0.99)),
+                  static_cast<unsigned long long>(result.latency.percentile(0.999)),
+                  static_cast<unsigned long long>(result.latency.max()));
+    std::string out = "{\"scenario\":\"" + result.scenario + "\",\"threads\":" +
+                      std::to_string(result.threads) + "," + numbers + ",\"histogram\":";
+    result.latency.appendJson(out);
+    out += '}';
+    return out;
+}
+
+// Число после "key": в строке результата; -1, если ключа нет
+static double jsonNumber(const std::string& line, const std::string& key) {
+    std::size_t position = line.find("\"" + key + "\":");
+    if (position == std::string::npos) {
+        return -1.0;
+    }
+    return std::strtod(line.c_str() + position + key.size() + 3, nullptr);
+}
+
+static std::string jsonString(const std::string& line, const std::string& key) {
+    std::size_t position = line.find("\"" + key + "\":\"");
+    if (position == std::string::npos) {
+        return std::string();
+    }
+    position += key.size() + 4;
+    return line.substr(position, line.find('"', position) - position);
+}
+
+int main(int argc, char** argv) {
+    int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    std::size_t records = 200000;
+    std::string out_path;
+    std::string baseline_path;
+    double tolerance = 0.10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string option = argv[i];
+        if (option == "--threads") {
+            max_threads = std::max(1, std::atoi(argv[i + 1]));
+        } else if (option == "--records") {
+            records = static_cast<std::size_t>(std::max(1, std::atoi(argv[i + 1])));
+        } else if (option == "--out") {
+            out_path = argv[i + 1];
+        } else if (option == "--baseline") {
+            baseline_path = argv[i + 1];
+        } else if (option == "--tolerance") {
+            tolerance = std::atof(argv[i + 1]);
+        } else {
+            std::cerr << "unknown option " << option << std::endl;
+            return 2;
+        }
+    }
+    if (argc % 2 == 0) {
+        std::cerr << "usage: " << argv[0] << " [--threads N] [--records N] [--out file.json]"
+                  << " [--baseline file.json] [--tolerance 0.1]" << std::endl;
+        return 2;
+    }
+
+    std::vector<Scenario> scenarios = {
+        {"null", [](Logger& logger, const std::string&) {
+            logger.addHandler(std::make_unique<NullHandler>());
+        }},
+        {"level_filtered_out", [](Logger& logger, const std::string&) {
+            logger.addFilter(std::make_unique<LevelFilter>(LogLevel::INFO));
+            logger.addHandler(std::make_unique<NullHandler>());
+        }, LogLevel::DEBUG},
+        {"level+timestamp+null", [](Logger& logger, const std::string&) {
+            logger.addFilter(std::make_unique<LevelFilter>(LogLevel::INFO));
+            logger.addFormatter(std::make_unique<TimestampFormatter>());
+            logger.addHandler(std::make_unique<NullHandler>());
+        }},
+        {"regex+keywords+timestamp+null", [](Logger& logger, const std::string&) {
+            logger.addFilter(std::make_unique<ReLogFilter>("worker [0-7]"));
+            logger.addFilter(std::make_unique<KeywordLogFilter>(
+                std::vector<std::string>{"status=200", "status=503", "timeout"}));
+            logger.addFormatter(std::make_unique<TimestampFormatter>());
+            logger.addHandler(std::make_unique<NullHandler>());
+        }},
+        {"timestamp+file", [](Logger& logger, const std::string& file) {
+            logger.addFormatter(std::make_unique<TimestampFormatter>());
+            logger.addHandler(std::make_unique<FileHandler>(file));
+        }},
+        {"async:timestamp+file", [](Logger& logger, const std::string& file) {
+            logger.addFormatter(std::make_unique<TimestampFormatter>());
+            logger.addHandler(std::make_unique<FileHandler>(file));
+        }, LogLevel::INFO, true},
+        {"async:timestamp+file+index", [](Logger& logger, const std::string& file) {
+            logger.addFormatter(std::make_unique<TimestampFormatter>());
+            auto handler = std::make_unique<FileHandler>(file);
+            handler->enableIndex();
+            logger.addHandler(std::move(handler));
+        }, LogLevel::INFO, true},
+    };
+
+    std::vector<int> thread_counts;
+    for (int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::string file = (std::filesystem::temp_directory_path() / "logger_bench.log").string();
+    std::vector<std::string> messages = makeMessages();
+    std::vector<Result> results;
+    std::printf("%-32s %7s %14s %9s %9s %9s %9s\n", "scenario", "threads", "records/s", "p50 ns", "p99 ns",
+                "p999 ns", "max ns");
+    for (const auto& scenario : scenarios) {
+        for (int threads : thread_counts) {
+            Result result = runScenario(scenario, threads, records, file, messages);
+            std::printf("%-32s %7d %14.0f %9llu %9llu %9llu %9llu\n", result.scenario.c_str(), result.threads,
+                        result.throughput, static_cast<unsigned long long>(result.latency.percentile(0.50)),
+                        static_cast<unsigned long long>(result.latency.percentile(0.99)),
+                        static_cast<unsigned long long>(result.latency.percentile(0.999)),
+                        static_cast<unsigned long long>(result.latency.max()));
+            std::fflush(stdout);
+            results.push_back(std::move(result));
+        }
+    }
+
+    if (!out_path.empty()) {
+        std::ofstream out(out_path);
+        out << "[\n";
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            out << toJson(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "]\n";
+    }
+
+    if (baseline_path.empty()) {
+        return 0;
+    }
+    std::ifstream baseline(baseline_path);
+    if (!baseline) {
+        std::cerr << baseline_path << ": cannot open" << std::endl;
+        return 2;
+    }
+    std::map<std::pair<std::string, int>, std::pair<double, double>> previous; // throughput, p99
+    std::string line;
+    while (std::getline(baseline, line)) {
+        std::string scenario = jsonString(line, "scenario");
+        if (!scenario.empty()) {
+            previous[{scenario, static_cast<int>(jsonNumber(line, "threads"))}] = {
+                jsonNumber(line, "throughput"), jsonNumber(line, "p99_ns")};
+        }
+    }
+    bool regressed = false;
+    std::printf("\n%-32s %7s %12s %12s\n", "vs baseline", "threads", "throughput", "p99");
+    for (const auto& result : results) {
+        auto found = previous.find({result.scenario, result.threads});
+        if (found == previous.end() || found->second.first <= 0 || found->second.second <= 0) {
+            continue;
+        }
+        double throughput_change = result.throughput / found->second.first - 1.0;
+        double p99_change = static_cast<double>(result.latency.percentile(0.99)) / found->second.second - 1.0;
+        bool worse = throughput_change < -tolerance || p99_change > tolerance;
+        regressed = regressed || worse;
+        std::printf("%-32s %7d %+11.1f%% %+11.1f%%%s\n", result.scenario.c_str(), result.threads,
+                    throughput_change * 100.0, p99_change * 100.0, worse ? "  REGRESSION" : "");
+    }
+    return regressed ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "substring_search.hpp"
+
+// Сравнение ядер SubstringSearcher и std::string::find на строках,
+// похожих на реальные логи (100-500 байт)
+
+static std::vector<std::string> makeLogLines(std::size_t count) {
+    static const char* words[] = {
+        "request", "handled", "user", "session", "cache", "miss", "hit", "db.pool",
+        "net.http", "GET", "POST", "/api/v1/items", "latency_us=", "status=200",
+        "status=503", "retry", "connection", "timeout", "upstream", "payload",
+        "bytes", "queue", "worker", "shard", "commit", "rollback", "token", "refresh"
+    };
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::size_t> word(0, sizeof(words) / sizeof(words[0]) - 1);
+    std::uniform_int_distribution<std::size_t> length(100, 500);
+    std::uniform_int_distribution<int> number(0, 99999);
+
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        std::string line = "[INFO] [2024.03.15 12:34:56.789] ";
+        std::size_t target = length(rng);
+        while (line.size() < target) {
+            line += words[word(rng)];
+            line += ' ';
+            if (number(rng) % 3 == 0) {
+                line += std::to_string(number(rng));
+                line += ' ';
+            }
+        }
+        line.resize(target);
+        // Примерно каждая сотая строка содержит искомое слово
+        if (i % 100 == 0) {
+            line.replace(target / 2, 9, "important");
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+template<typename Search>
+static void run(const char* name, const std::vector<std::string>& lines, Search search) {
+    const int rounds = 50;
+    std::size_t bytes = 0;
+    for (const std::string& line : lines) {
+        bytes += line.size();
+    }
+
+    std::size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        for (const std::string& line : lines) {
+            hits += search(line) ? 1 : 0;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    double per_line_ns = seconds * 1e9 / (static_cast<double>(lines.size()) * rounds);
+    double gb_per_s = static_cast<double>(bytes) * rounds / seconds / 1e9;
+    std::printf("  %-18s %8.1f ns/line %8.2f GB/s  (hits: %zu)\n", name, per_line_ns, gb_per_s, hits / rounds);
+}
+
+int main() {
+    std::vector<std::string> lines = makeLogLines(20000);
+
+    for (const char* needle : {"important", "status=503", "ERROR", "db"}) {
+        std::cout << "needle \"" << needle << "\"" << std::endl;
+        std::string pattern = needle;
+        run("std::string::find", lines, [&pattern](const std::string& line) {
+            return line.find(pattern) != std::string::npos;
+        });
+
+        for (SearchKernel kernel : {SearchKernel::SCALAR, SearchKernel::SSE2, SearchKernel::AVX2}) {
+            if (!SubstringSearcher::isSupported(kernel)) {
+                continue;
+            }
+            SubstringSearcher searcher(pattern, kernel);
+            const char* name = kernel == SearchKernel::SCALAR ? "scalar"
+                             : kernel == SearchKernel::SSE2 ? "sse2" : "avx2";
+            run(name, lines, [&searcher](const std::string& line) {
+                return searcher.contains(line);
+            });
+        }
+    }
+    return 0;
+}
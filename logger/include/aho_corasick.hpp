@@ -0,0 +1,166 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Поиск множества ключевых слов за один проход (автомат Ахо-Корасик).
+// Переходы хранятся полной таблицей states x classes, где classes - только
+// байты, встречающиеся в ключевых словах (остальные сведены в класс 0),
+// поэтому на каждый байт текста приходится одно чтение таблицы.
+// После построения объект только читается и безопасен из нескольких потоков.
+class AhoCorasick {
+private:
+    std::uint16_t byte_class_[256] = {}; // классов до 257: все байты и класс 0
+    std::size_t class_count_ = 1;
+    std::vector<std::uint32_t> delta_;
+    std::vector<std::int32_t> pattern_at_;   // номер слова, оканчивающегося в состоянии, или -1
+    std::vector<std::int32_t> output_link_;  // ближайшее по суффиксным ссылкам состояние с pattern_at_ != -1
+    std::vector<std::uint8_t> has_output_;   // в состоянии оканчивается хотя бы одно слово
+    std::size_t pattern_count_ = 0;
+    bool has_empty_pattern_ = false;
+
+    std::uint32_t next(std::uint32_t state, unsigned char byte) const {
+        return delta_[state * class_count_ + byte_class_[byte]];
+    }
+
+public:
+    explicit AhoCorasick(const std::vector<std::string>& patterns) {
+        // Сжатие алфавита
+        for (const std::string& pattern : patterns) {
+            for (char c : pattern) {
+                auto byte = static_cast<unsigned char>(c);
+                if (byte_class_[byte] == 0) {
+                    byte_class_[byte] = static_cast<std::uint16_t>(class_count_++);
+                }
+            }
+        }
+
+        // Бор; 0 в таблице означает "перехода нет" (в корень никто не ведёт)
+        delta_.assign(class_count_, 0);
+        pattern_at_.push_back(-1);
+        std::unordered_map<std::string, std::int32_t> unique_patterns;
+        for (const std::string& pattern : patterns) {
+            if (pattern.empty()) {
+                has_empty_pattern_ = true;
+                continue;
+            }
+            if (unique_patterns.count(pattern) != 0) {
+                continue;
+            }
+            auto id = static_cast<std::int32_t>(unique_patterns.size());
+            unique_patterns.emplace(pattern, id);
+
+            std::uint32_t state = 0;
+            for (char c : pattern) {
+                std::size_t cell = state * class_count_ + byte_class_[static_cast<unsigned char>(c)];
+                if (delta_[cell] == 0) {
+                    delta_[cell] = static_cast<std::uint32_t>(pattern_at_.size());
+                    pattern_at_.push_back(-1);
+                    delta_.resize(pattern_at_.size() * class_count_, 0);
+                }
+                state = delta_[cell];
+            }
+            pattern_at_[state] = id;
+        }
+        pattern_count_ = unique_patterns.size();
+
+        // Суффиксные ссылки обходом в ширину; недостающие переходы
+        // достраиваются до полного автомата
+        std::size_t states = pattern_at_.size();
+        std::vector<std::uint32_t> fail(states, 0);
+        output_link_.assign(states, -1);
+        has_output_.assign(states, 0);
+        std::queue<std::uint32_t> queue;
+        for (std::size_t c = 0; c < class_count_; ++c) {
+            std::uint32_t child = delta_[c];
+            if (child != 0) {
+                queue.push(child);
+            }
+        }
+        while (!queue.empty()) {
+            std::uint32_t state = queue.front();
+            queue.pop();
+            std::uint32_t link = fail[state];
+            output_link_[state] = pattern_at_[link] >= 0 ? static_cast<std::int32_t>(link) : output_link_[link];
+            has_output_[state] = pattern_at_[state] >= 0 || output_link_[state] >= 0;
+
+            for (std::size_t c = 0; c < class_count_; ++c) {
+                std::uint32_t& child = delta_[state * class_count_ + c];
+                std::uint32_t fallback = delta_[link * class_count_ + c];
+                if (child != 0) {
+                    fail[child] = fallback;
+                    queue.push(child);
+                } else {
+                    child = fallback;
+                }
+            }
+        }
+    }
+
+    std::size_t patternCount() const {
+        return pattern_count_;
+    }
+
+    // Встречается ли в тексте хотя бы одно ключевое слово
+    bool containsAny(std::string_view text) const {
+        if (has_empty_pattern_) {
+            return true;
+        }
+        std::uint32_t state = 0;
+        for (char c : text) {
+            state = next(state, static_cast<unsigned char>(c));
+            if (has_output_[state]) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Встречаются ли в тексте все ключевые слова
+    bool containsAll(std::string_view text) const {
+        if (pattern_count_ == 0) {
+            return true;
+        }
+        // Отметки найденных слов переиспользуются между вызовами: вместо
+        // очистки массива увеличивается номер поколения
+        struct Scratch {
+            std::vector<std::uint32_t> seen;
+            std::uint32_t generation = 0;
+        };
+        static thread_local Scratch scratch;
+        if (scratch.seen.size() < pattern_count_) {
+            scratch.seen.assign(pattern_count_, 0);
+            scratch.generation = 0;
+        }
+        if (++scratch.generation == 0) {
+            std::fill(scratch.seen.begin(), scratch.seen.end(), 0);
+            scratch.generation = 1;
+        }
+
+        std::size_t found = 0;
+        std::uint32_t state = 0;
+        for (char c : text) {
+            state = next(state, static_cast<unsigned char>(c));
+            if (!has_output_[state]) {
+                continue;
+            }
+            std::int32_t hit = pattern_at_[state] >= 0 ? static_cast<std::int32_t>(state) : output_link_[state];
+            while (hit >= 0) {
+                std::uint32_t& mark = scratch.seen[pattern_at_[hit]];
+                if (mark != scratch.generation) {
+                    mark = scratch.generation;
+                    if (++found == pattern_count_) {
+                        return true;
+                    }
+                }
+                hit = output_link_[hit];
+            }
+        }
+        return false;
+    }
+};
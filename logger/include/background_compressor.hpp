@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "bounded_queue.hpp"
+#include "lz_codec.hpp"
+
+// Сжимает закрытые файлы логов в фоновом потоке с пониженным приоритетом.
+// submit() только кладёт путь в очередь; если очередь заполнена, путь
+// откладывается и возвращается в очередь, когда она опустеет, так что
+// пишущий поток никогда не ждёт компрессор, а файлы не теряются.
+// Результат - <файл>.lz, исходный файл удаляется после успешного сжатия.
+// Несжатые при остановке файлы подбирает submitRotated при следующем запуске
+class BackgroundCompressor {
+private:
+    BoundedQueue<std::string> queue_;
+    mutable std::mutex overflow_mutex_; // overflow_ и переход очереди из полной в пустую
+    std::deque<std::string> overflow_;
+    std::thread worker_;
+    std::atomic<std::size_t> compressed_{0};
+    std::atomic<std::size_t> failed_{0};
+
+    void workerLoop() {
+#ifdef SYS_gettid
+        // В Linux приоритет nice задаётся для отдельного потока
+        ::setpriority(PRIO_PROCESS, static_cast<id_t>(::syscall(SYS_gettid)), 19);
+#endif
+        std::string path;
+        while (queue_.pop(path)) {
+            if (LzCodec::compressFile(path, path + ".lz")) {
+                std::remove(path.c_str());
+                compressed_.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                failed_.fetch_add(1, std::memory_order_relaxed);
+            }
+            requeueOverflow();
+        }
+    }
+
+    // Очередь опустела - возвращаем в неё отложенные пути
+    void requeueOverflow() {
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        if (queue_.size() != 0) {
+            return;
+        }
+        while (!overflow_.empty() && queue_.push(std::string(overflow_.front()))) {
+            overflow_.pop_front();
+        }
+    }
+
+    // <файл>.<время> или <файл>.<время>-<n> (см. BufferedFileWriter::rotateLocked)
+    static bool isRotatedName(const std::string& name, const std::string& base_name) {
+        if (name.size() <= base_name.size() + 1 || name.compare(0, base_name.size() + 1, base_name + ".") != 0) {
+            return false;
+        }
+        std::size_t dash = 0;
+        for (std::size_t i = base_name.size() + 1; i < name.size(); ++i) {
+            if (name[i] == '-' && dash == 0 && i > base_name.size() + 1 && i + 1 < name.size()) {
+                dash = i;
+            } else if (!std::isdigit(static_cast<unsigned char>(name[i]))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    explicit BackgroundCompressor(std::size_t queue_capacity = 64)
+        : queue_(queue_capacity, OverflowPolicy::DROP_NEWEST) {
+        worker_ = std::thread(&BackgroundCompressor::workerLoop, this);
+    }
+
+    BackgroundCompressor(const BackgroundCompressor&) = delete;
+    BackgroundCompressor& operator=(const BackgroundCompressor&) = delete;
+
+    // Досжимает уже поставленные в очередь файлы и останавливается
+    ~BackgroundCompressor() {
+        queue_.close();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    // false - очередь заполнена, файл сожмётся позже
+    bool submit(const std::string& path) {
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        if (queue_.push(std::string(path))) {
+            return true;
+        }
+        overflow_.push_back(path);
+        return false;
+    }
+
+    // Ставит в очередь закрытые части log_file, оставшиеся несжатыми с
+    // прошлого запуска (компрессор остановился или не успевал); возвращает
+    // их число
+    std::size_t submitRotated(const std::string& log_file) {
+        std::filesystem::path file(log_file);
+        std::filesystem::path directory = file.has_parent_path() ? file.parent_path() : std::filesystem::path(".");
+        std::string base_name = file.filename().string();
+        std::vector<std::string> rotated;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+            if (entry.is_regular_file(error) && isRotatedName(entry.path().filename().string(), base_name)) {
+                rotated.push_back(entry.path().string());
+            }
+        }
+        std::sort(rotated.begin(), rotated.end());
+        for (const auto& path : rotated) {
+            submit(path);
+        }
+        return rotated.size();
+    }
+
+    std::size_t compressedCount() const {
+        return compressed_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t failedCount() const {
+        return failed_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t pending() const {
+        std::lock_guard<std::mutex> lock(overflow_mutex_);
+        return queue_.size() + overflow_.size();
+    }
+};
@@ -0,0 +1,494 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include "buffered_file.hpp"
+#include "format_string.hpp"
+
+// Кодирование аргументов отложенного форматирования. Тип каждого аргумента
+// задаётся символом сигнатуры, в записи лежат только значения:
+//   i - int64, u - uint64, d - double (по 8 байт), b - bool, c - char (1 байт),
+//   p - указатель (8 байт), s - строка ([uint16 длина][байты]).
+// Порядок байтов - как у записавшей машины.
+class DeferredArgs {
+private:
+    template<typename T>
+    static void putRaw(char* out, std::size_t& used, const T& value) {
+        if (used + sizeof(T) <= MaxArgsSize) {
+            std::memcpy(out + used, &value, sizeof(T));
+            used += sizeof(T);
+        } else {
+            used = MaxArgsSize; // не поместилось - остальные аргументы тоже пропускаем
+        }
+    }
+
+    template<typename T>
+    static void put(char* out, std::size_t& used, const T& value) {
+        constexpr char code = typeCode<T>();
+        if constexpr (code == 'b' || code == 'c') {
+            putRaw(out, used, static_cast<char>(value));
+        } else if constexpr (code == 'i') {
+            putRaw(out, used, static_cast<std::int64_t>(value));
+        } else if constexpr (code == 'u') {
+            putRaw(out, used, static_cast<std::uint64_t>(value));
+        } else if constexpr (code == 'd') {
+            putRaw(out, used, static_cast<double>(value));
+        } else if constexpr (code == 'p') {
+            putRaw(out, used, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(value)));
+        } else {
+            std::string_view text;
+            if constexpr (std::is_pointer_v<T>) {
+                text = value != nullptr ? std::string_view(value) : std::string_view("(null)");
+            } else {
+                text = value;
+            }
+            if (used + 2 > MaxArgsSize) {
+                used = MaxArgsSize;
+                return;
+            }
+            std::size_t length = text.size();
+            if (length > MaxArgsSize - used - 2) {
+                length = MaxArgsSize - used - 2; // длинная строка обрезается
+            }
+            std::uint16_t length16 = static_cast<std::uint16_t>(length);
+            std::memcpy(out + used, &length16, 2);
+            std::memcpy(out + used + 2, text.data(), length);
+            used += 2 + length;
+        }
+    }
+
+    template<typename T>
+    static bool take(const char*& args, const char* end, T& value) {
+        if (static_cast<std::size_t>(end - args) < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, args, sizeof(T));
+        args += sizeof(T);
+        return true;
+    }
+
+public:
+    static constexpr std::size_t MaxArgsSize = 1024;
+
+    template<typename T>
+    static constexpr char typeCode() {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, bool>) {
+            return 'b';
+        } else if constexpr (std::is_same_v<Type, char>) {
+            return 'c';
+        } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+            return 'i';
+        } else if constexpr (std::is_integral_v<Type>) {
+            return 'u';
+        } else if constexpr (std::is_enum_v<Type>) {
+            return 'i';
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            return 'd';
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            return 's';
+        } else if constexpr (std::is_pointer_v<Type>) {
+            return 'p';
+        } else {
+            static_assert(std::is_pointer_v<Type>, "unsupported deferred log argument type");
+            return '?';
+        }
+    }
+
+    template<typename... Args>
+    static std::string signature() {
+        return std::string{typeCode<Args>()...};
+    }
+
+    // Кодирует аргументы в out (не менее MaxArgsSize байт), возвращает размер
+    template<typename... Args>
+    static std::size_t encode(char* out, const Args&... args) {
+        std::size_t used = 0;
+        (put(out, used, args), ...);
+        return used;
+    }
+
+    // Подставляет аргументы вместо подстановок строки формата (см. format_string.hpp).
+    // Недостающие аргументы выводятся как "{?}", лишние игнорируются
+    static void render(std::string_view format, std::string_view signature,
+                       const char* args, std::size_t size, std::string& out) {
+        if (!FormatString::isValid(format)) {
+            out += format;
+            return;
+        }
+        const char* end = args + size;
+        std::size_t next = 0;
+        FormatString::walk(format, [&](const FormatOp& op) {
+            if (!op.is_argument) {
+                out.append(format.data() + op.begin, op.length);
+            } else if (next >= signature.size() || !appendArg(signature[next++], op, args, end, out)) {
+                out += "{?}";
+            }
+        });
+    }
+
+    static bool appendArg(char code, const FormatOp& op, const char*& args, const char* end, std::string& out) {
+        switch (code) {
+            case 'b': {
+                char value;
+                if (!take(args, end, value)) {
+                    return false;
+                }
+                FormatString::appendValue(out, value != 0, op);
+                return true;
+            }
+            case 'c': {
+                char value;
+                if (!take(args, end, value)) {
+                    return false;
+                }
+                FormatString::appendValue(out, value, op);
+                return true;
+            }
+            case 'i': {
+                std::int64_t value;
+                if (!take(args, end, value)) {
+                    return false;
+                }
+                FormatString::appendValue(out, value, op);
+                return true;
+            }
+            case 'u': {
+                std::uint64_t value;
+                if (!take(args, end, value)) {
+                    return false;
+                }
+                FormatString::appendValue(out, value, op);
+                return true;
+            }
+            case 'd': {
+                double value;
+                if (!take(args, end, value)) {
+                    return false;
+                }
+                FormatString::appendValue(out, value, op);
+                return true;
+            }
+            case 'p': {
+                std::uint64_t value;
+                if (!take(args, end, value)) {
+                    return false;
+                }
+                FormatOp hex = op;
+                hex.spec = FormatSpec::HEX;
+                out += "0x";
+                FormatString::appendValue(out, value, hex);
+                return true;
+            }
+            case 's': {
+                std::uint16_t length;
+                if (!take(args, end, length) || static_cast<std::size_t>(end - args) < length) {
+                    return false;
+                }
+                FormatString::appendValue(out, std::string_view(args, length), op);
+                args += length;
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+};
+
+// Строка формата с сигнатурой аргументов
+struct DeferredFormat {
+    std::uint32_t id;    // устойчивый между запусками: хэш формата и сигнатуры
+    std::uint32_t index; // порядковый номер в процессе
+    std::string format;
+    std::string signature;
+};
+
+// Общий для процесса реестр строк формата. Регистрация выполняется один раз
+// для каждого места вызова (см. Logger::logDeferred), поэтому мьютекс не
+// попадает на горячий путь
+class DeferredFormatRegistry {
+private:
+    std::mutex mutex_;
+    std::deque<DeferredFormat> formats_; // адреса элементов не меняются
+    std::unordered_map<std::uint32_t, const DeferredFormat*> by_id_;
+
+    static std::uint32_t hash(std::string_view format, std::string_view signature) {
+        std::uint32_t value = 2166136261u; // FNV-1a
+        auto mix = [&value](std::string_view text) {
+            for (char c : text) {
+                value = (value ^ static_cast<unsigned char>(c)) * 16777619u;
+            }
+        };
+        mix(signature);
+        mix(std::string_view("\0", 1));
+        mix(format);
+        return value;
+    }
+
+public:
+    static constexpr std::uint32_t MaxFormats = 65536;
+
+    static DeferredFormatRegistry& instance() {
+        static DeferredFormatRegistry registry;
+        return registry;
+    }
+
+    // nullptr - реестр заполнен
+    const DeferredFormat* intern(std::string_view format, const std::string& signature) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::uint32_t id = hash(format, signature);
+        for (;;) {
+            auto found = by_id_.find(id);
+            if (found == by_id_.end()) {
+                break;
+            }
+            if (found->second->format == format && found->second->signature == signature) {
+                return found->second;
+            }
+            ++id; // редкая коллизия хэшей
+        }
+        if (formats_.size() >= MaxFormats) {
+            return nullptr;
+        }
+        formats_.push_back(DeferredFormat{id, static_cast<std::uint32_t>(formats_.size()),
+                                          std::string(format), signature});
+        by_id_[id] = &formats_.back();
+        return &formats_.back();
+    }
+};
+
+// Строка таблицы форматов <файл>.fmt: "<id hex>\t<сигнатура>\t<формат>",
+// '\\', '\n' и '\t' в формате экранированы
+struct FormatTableLine {
+    static std::string make(std::uint32_t id, const DeferredFormat& format) {
+        std::string line;
+        char hex[16];
+        std::snprintf(hex, sizeof(hex), "%08x\t", id);
+        line += hex;
+        line += format.signature;
+        line += '\t';
+        for (char c : format.format) {
+            switch (c) {
+                case '\\': line += "\\\\"; break;
+                case '\n': line += "\\n"; break;
+                case '\t': line += "\\t"; break;
+                default: line += c;
+            }
+        }
+        line += '\n';
+        return line;
+    }
+
+    // false - строка повреждена
+    static bool parse(const std::string& line, DeferredFormat& format) {
+        std::size_t first = line.find('\t');
+        std::size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+        if (second == std::string::npos) {
+            return false;
+        }
+        format.id = static_cast<std::uint32_t>(std::strtoul(line.c_str(), nullptr, 16));
+        format.index = 0;
+        format.signature = line.substr(first + 1, second - first - 1);
+        format.format.clear();
+        for (std::size_t i = second + 1; i < line.size(); ++i) {
+            if (line[i] == '\\' && i + 1 < line.size()) {
+                char next = line[++i];
+                format.format += next == 'n' ? '\n' : (next == 't' ? '\t' : next);
+            } else {
+                format.format += line[i];
+            }
+        }
+        return true;
+    }
+};
+
+// Заголовок записи в двоичном журнале
+struct BinaryRecordHeader {
+    std::uint32_t format_id;
+    std::int64_t timestamp_ns;
+    std::uint8_t level;
+    std::uint16_t args_size;
+};
+
+// Двоичный журнал отложенного форматирования: файл начинается с "BLOG0001",
+// далее записи [uint32 id формата][int64 время, нс][uint8 уровень]
+// [uint16 размер аргументов][аргументы]. Рядом лежит таблица форматов
+// <файл>.fmt (см. FormatTableLine). Строка таблицы дописывается и
+// сбрасывается на диск до первой записи с этим форматом. Если id формата
+// в таблице уже занят другим форматом (из прошлого запуска), в файле
+// используется следующий свободный id. Текст восстанавливает tools/log_decode
+class BinaryLogWriter {
+private:
+    static constexpr std::size_t HeaderSize = 4 + 8 + 1 + 2;
+
+    std::string table_path_;
+    bool fresh_; // файл пуст - нужен заголовок
+    BufferedFileWriter file_;
+
+    std::unique_ptr<std::atomic<bool>[]> table_written_; // по DeferredFormat::index
+    std::unique_ptr<std::uint32_t[]> file_ids_;          // id в этом файле, по DeferredFormat::index
+    std::mutex table_mutex_;
+    std::unordered_map<std::uint32_t, DeferredFormat> table_; // уже в таблице (в т.ч. из прошлых запусков)
+
+    static bool isEmpty(const std::string& path) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        return error || size == 0;
+    }
+
+    void loadTable() {
+        std::ifstream table(table_path_);
+        std::string line;
+        DeferredFormat format;
+        while (std::getline(table, line)) {
+            if (FormatTableLine::parse(line, format)) {
+                table_[format.id] = format;
+            }
+        }
+    }
+
+    void addToTable(const DeferredFormat& format) {
+        std::lock_guard<std::mutex> lock(table_mutex_);
+        if (table_written_[format.index].load(std::memory_order_relaxed)) {
+            return;
+        }
+        std::uint32_t id = format.id;
+        for (;;) {
+            auto found = table_.find(id);
+            if (found == table_.end()) {
+                std::string line = FormatTableLine::make(id, format);
+                std::FILE* table = std::fopen(table_path_.c_str(), "a");
+                if (table != nullptr) {
+                    std::fwrite(line.data(), 1, line.size(), table);
+                    std::fclose(table);
+                }
+                table_[id] = format;
+                break;
+            }
+            if (found->second.format == format.format && found->second.signature == format.signature) {
+                break;
+            }
+            ++id; // id занят другим форматом
+        }
+        file_ids_[format.index] = id;
+        table_written_[format.index].store(true, std::memory_order_release);
+    }
+
+public:
+    explicit BinaryLogWriter(const std::string& path,
+                             std::size_t buffer_size = 256 * 1024,
+                             std::chrono::milliseconds flush_interval = std::chrono::milliseconds(200))
+        : table_path_(path + ".fmt"), fresh_(isEmpty(path)), file_(path, buffer_size, flush_interval),
+          table_written_(new std::atomic<bool>[DeferredFormatRegistry::MaxFormats]),
+          file_ids_(new std::uint32_t[DeferredFormatRegistry::MaxFormats]) {
+        for (std::uint32_t i = 0; i < DeferredFormatRegistry::MaxFormats; ++i) {
+            table_written_[i].store(false, std::memory_order_relaxed);
+        }
+        loadTable();
+        if (fresh_) {
+            file_.append("BLOG0001", 8);
+        }
+    }
+
+    BinaryLogWriter(const BinaryLogWriter&) = delete;
+    BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+    bool isOpen() const {
+        return file_.isOpen();
+    }
+
+    void write(const DeferredFormat& format, std::uint8_t level, std::int64_t timestamp_ns,
+               const char* args, std::size_t args_size) {
+        if (!table_written_[format.index].load(std::memory_order_acquire)) {
+            addToTable(format);
+        }
+        char record[HeaderSize + DeferredArgs::MaxArgsSize];
+        std::uint16_t size16 = static_cast<std::uint16_t>(args_size);
+        std::memcpy(record, &file_ids_[format.index], 4);
+        std::memcpy(record + 4, &timestamp_ns, 8);
+        record[12] = static_cast<char>(level);
+        std::memcpy(record + 13, &size16, 2);
+        std::memcpy(record + HeaderSize, args, args_size);
+        file_.append(record, HeaderSize + args_size);
+    }
+
+    void flush() {
+        file_.sync();
+    }
+
+    std::size_t bytesWritten() const {
+        return file_.bytesWritten();
+    }
+
+    // Из обработчика сигнала (см. BufferedFileWriter::crashFlush)
+    void crashFlush() noexcept {
+        file_.crashFlush();
+    }
+};
+
+// Чтение двоичного журнала (для tools/log_decode)
+class BinaryLogReader {
+private:
+    std::ifstream file_;
+    std::unordered_map<std::uint32_t, DeferredFormat> formats_;
+    bool good_ = false;
+
+public:
+    BinaryLogReader(const std::string& path, const std::string& table_path)
+        : file_(path, std::ios::binary) {
+        std::ifstream table(table_path);
+        std::string line;
+        DeferredFormat format;
+        while (std::getline(table, line)) {
+            if (FormatTableLine::parse(line, format)) {
+                formats_[format.id] = format;
+            }
+        }
+        char magic[8];
+        good_ = file_.read(magic, 8) && std::memcmp(magic, "BLOG0001", 8) == 0;
+    }
+
+    bool good() const {
+        return good_;
+    }
+
+    // Читает следующую запись и рендерит её текст; false - конец файла
+    // (или обрезанная последняя запись)
+    bool next(BinaryRecordHeader& header, std::string& text) {
+        char raw[15];
+        if (!good_ || !file_.read(raw, sizeof(raw))) {
+            return false;
+        }
+        std::memcpy(&header.format_id, raw, 4);
+        std::memcpy(&header.timestamp_ns, raw + 4, 8);
+        header.level = static_cast<std::uint8_t>(raw[12]);
+        std::memcpy(&header.args_size, raw + 13, 2);
+        char args[DeferredArgs::MaxArgsSize];
+        if (header.args_size > sizeof(args) || !file_.read(args, header.args_size)) {
+            return false;
+        }
+        text.clear();
+        auto found = formats_.find(header.format_id);
+        if (found == formats_.end()) {
+            char unknown[48];
+            std::snprintf(unknown, sizeof(unknown), "<unknown format %08x>", header.format_id);
+            text += unknown;
+            return true;
+        }
+        DeferredArgs::render(found->second.format, found->second.signature, args, header.args_size, text);
+        return true;
+    }
+};
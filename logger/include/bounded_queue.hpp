@@ -0,0 +1,133 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Что делать, если очередь заполнена
+enum class OverflowPolicy {
+    BLOCK,       // ждать, пока потребитель освободит место
+    DROP_NEWEST, // отбросить новую запись
+    DROP_OLDEST  // вытеснить самую старую запись
+};
+
+// Ограниченная очередь с одним потребителем и настраиваемой политикой
+// переполнения. Хранилище выделяется один раз в конструкторе.
+// Записи, для которых pinned(item) == true (служебные, например маркеры
+// сброса), при DROP_OLDEST не вытесняются: жертвой становится самая старая
+// из остальных, а если закреплены все, push ждёт как при BLOCK
+template<typename T>
+class BoundedQueue {
+private:
+    std::vector<T> items_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    std::size_t dropped_ = 0;
+    bool closed_ = false;
+    OverflowPolicy policy_;
+    std::function<bool(const T&)> pinned_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+
+    void pushLocked(T&& value) {
+        items_[(head_ + size_) % items_.size()] = std::move(value);
+        ++size_;
+    }
+
+public:
+    BoundedQueue(std::size_t capacity, OverflowPolicy policy, std::function<bool(const T&)> pinned = nullptr)
+        : items_(capacity > 0 ? capacity : 1), policy_(policy), pinned_(std::move(pinned)) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    // Возвращает false, если запись (новая или вытесненная старая) потеряна
+    bool push(T&& value) {
+        return push(std::move(value), policy_);
+    }
+
+    bool push(T&& value, OverflowPolicy policy) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (closed_) {
+            return false;
+        }
+        bool lost = false;
+        if (size_ == items_.size()) {
+            switch (policy) {
+                case OverflowPolicy::BLOCK:
+                    not_full_.wait(lock, [this] { return size_ < items_.size() || closed_; });
+                    if (closed_) {
+                        return false;
+                    }
+                    break;
+                case OverflowPolicy::DROP_NEWEST:
+                    ++dropped_;
+                    return false;
+                case OverflowPolicy::DROP_OLDEST: {
+                    std::size_t victim = 0;
+                    while (victim < size_ && pinned_ && pinned_(items_[(head_ + victim) % items_.size()])) {
+                        ++victim;
+                    }
+                    if (victim == size_) {
+                        not_full_.wait(lock, [this] { return size_ < items_.size() || closed_; });
+                        if (closed_) {
+                            return false;
+                        }
+                        break;
+                    }
+                    // Закреплённые записи перед жертвой сдвигаются на её место
+                    for (std::size_t i = victim; i > 0; --i) {
+                        items_[(head_ + i) % items_.size()] = std::move(items_[(head_ + i - 1) % items_.size()]);
+                    }
+                    head_ = (head_ + 1) % items_.size();
+                    --size_;
+                    ++dropped_;
+                    lost = true;
+                    break;
+                }
+            }
+        }
+        pushLocked(std::move(value));
+        lock.unlock();
+        not_empty_.notify_one();
+        return !lost;
+    }
+
+    // Блокирует до появления записи; false - очередь закрыта и пуста
+    bool pop(T& out) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return size_ > 0 || closed_; });
+        if (size_ == 0) {
+            return false;
+        }
+        out = std::move(items_[head_]);
+        head_ = (head_ + 1) % items_.size();
+        --size_;
+        lock.unlock();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    std::size_t size() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return size_;
+    }
+
+    std::size_t dropped() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return dropped_;
+    }
+};
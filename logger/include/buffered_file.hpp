@@ -0,0 +1,337 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "crash_flush.hpp"
+
+// Буферизованная запись в файл блоками фиксированного размера.
+// Данные попадают в файл, когда блок заполнен или истёк интервал сброса.
+// В надёжном режиме фоновый поток делает один fsync на все записи,
+// накопленные за интервал (group commit), поэтому потери ограничены
+// одним интервалом и не требуют fsync на каждую строку.
+// При включённой ротации файл, выросший до max_file_size, переименовывается
+// в <файл>.<мс от эпохи> и передаётся обработчику on_rotate.
+// Запись идёт через POSIX open/write/fsync, поэтому проект собирается
+// только под Linux (см. CmakeLists.txt).
+class BufferedFileWriter {
+private:
+    static constexpr std::size_t BlockAlignment = 4096;
+
+    std::string filename_;
+    int fd_ = -1;
+    char* buffer_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t used_ = 0;
+    bool durable_ = false;
+    bool dirty_ = false; // записано в файл, но ещё не fsync
+    std::chrono::milliseconds flush_interval_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool stopping_ = false;
+    std::thread flusher_;
+    std::atomic<std::size_t> bytes_written_{0};
+    std::atomic<std::size_t> write_errors_{0};
+    std::atomic<std::size_t> lines_lost_{0};
+    std::atomic<int> last_error_{0};
+
+    std::size_t max_file_size_ = 0; // 0 - без ротации
+    std::size_t file_size_ = 0;
+    long long last_rotation_ms_ = 0;
+    std::function<void(const std::string&)> on_rotate_;
+    std::function<void(const char*, std::size_t)> on_line_;
+    std::string partial_line_; // начало строки, конец которой ещё в буфере
+
+    int openFile() {
+        return ::open(filename_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    }
+
+    // fsync выполняется без блокировки через копию дескриптора, чтобы
+    // ротация могла закрыть основной дескриптор в это время
+    static void syncDuplicate(int fd) {
+        if (fd >= 0) {
+            ::fsync(fd);
+            ::close(fd);
+        }
+    }
+
+    // Вызывается под mutex_
+    void rotateLocked() {
+        if (durable_) {
+            ::fsync(fd_);
+        }
+        ::close(fd_);
+        // Суффиксы строго возрастают: файл, уже забранный обработчиком
+        // on_rotate, не должен получить повторяющееся имя
+        long long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        last_rotation_ms_ = now_ms > last_rotation_ms_ ? now_ms : last_rotation_ms_ + 1;
+        std::string rotated = filename_ + "." + std::to_string(last_rotation_ms_);
+        std::string candidate = rotated;
+        for (int attempt = 1; ::access(candidate.c_str(), F_OK) == 0; ++attempt) {
+            candidate = rotated + "-" + std::to_string(attempt);
+        }
+        bool renamed = ::rename(filename_.c_str(), candidate.c_str()) == 0;
+        fd_ = openFile();
+        file_size_ = 0;
+        dirty_ = false;
+        if (renamed && on_rotate_) {
+            on_rotate_(candidate);
+        }
+    }
+
+    // Возвращает число записанных байт; меньше size - ошибка (errno)
+    static std::size_t writeAll(int fd, const char* data, std::size_t size) {
+        std::size_t total = 0;
+        while (total < size) {
+            ssize_t written = ::write(fd, data + total, size - total);
+            if (written <= 0) {
+                if (written < 0 && errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            total += static_cast<std::size_t>(written);
+        }
+        return total;
+    }
+
+    // Вызывается под mutex_. Передаёт on_line_ строки, целиком попавшие в файл
+    void notifyLinesLocked(const char* data, std::size_t size) {
+        const char* end = data + size;
+        while (data < end) {
+            const char* newline = static_cast<const char*>(std::memchr(data, '\n', end - data));
+            if (newline == nullptr) {
+                partial_line_.append(data, end - data);
+                return;
+            }
+            if (partial_line_.empty()) {
+                on_line_(data, newline - data);
+            } else {
+                partial_line_.append(data, newline - data);
+                on_line_(partial_line_.data(), partial_line_.size());
+                partial_line_.clear();
+            }
+            data = newline + 1;
+        }
+    }
+
+    // Вызывается под mutex_. При ошибке записи (ENOSPC, EIO) недописанный
+    // остаток буфера отбрасывается: учитываются ошибка и потерянные строки,
+    // а в счётчики размера попадает только то, что лежит в файле
+    void drainLocked() {
+        if (used_ == 0) {
+            return;
+        }
+        std::size_t written = writeAll(fd_, buffer_, used_);
+        if (written < used_) {
+            last_error_.store(errno, std::memory_order_relaxed);
+            write_errors_.fetch_add(1, std::memory_order_relaxed);
+            std::size_t lines = 0;
+            for (std::size_t i = written; i < used_; ++i) {
+                lines += buffer_[i] == '\n' ? 1 : 0;
+            }
+            lines_lost_.fetch_add(lines, std::memory_order_relaxed);
+        }
+        if (on_line_) {
+            notifyLinesLocked(buffer_, written);
+        }
+        bytes_written_.fetch_add(written, std::memory_order_relaxed);
+        file_size_ += written;
+        used_ = 0;
+        dirty_ = dirty_ || written > 0;
+    }
+
+    // Вызывается под mutex_
+    void copyLocked(const char* data, std::size_t size) {
+        while (size > 0) {
+            std::size_t chunk = capacity_ - used_;
+            if (chunk > size) {
+                chunk = size;
+            }
+            std::memcpy(buffer_ + used_, data, chunk);
+            used_ += chunk;
+            data += chunk;
+            size -= chunk;
+            if (used_ == capacity_) {
+                drainLocked();
+            }
+        }
+    }
+
+    // Вызывается под mutex_ на границе записей
+    void rotateIfNeededLocked() {
+        if (max_file_size_ > 0 && file_size_ + used_ >= max_file_size_) {
+            drainLocked();
+            rotateLocked();
+        }
+    }
+
+    void flusherLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wakeup_.wait_for(lock, flush_interval_);
+            drainLocked();
+            if (durable_ && dirty_) {
+                dirty_ = false;
+                // fsync без блокировки: писатели продолжают заполнять буфер
+                int fd = ::dup(fd_);
+                lock.unlock();
+                syncDuplicate(fd);
+                lock.lock();
+            }
+        }
+    }
+
+public:
+    explicit BufferedFileWriter(const std::string& filename,
+                                std::size_t buffer_size = 64 * 1024,
+                                std::chrono::milliseconds flush_interval = std::chrono::milliseconds(200),
+                                bool durable = false)
+        : filename_(filename), durable_(durable), flush_interval_(flush_interval) {
+        capacity_ = (buffer_size + BlockAlignment - 1) / BlockAlignment * BlockAlignment;
+        if (capacity_ == 0) {
+            capacity_ = BlockAlignment;
+        }
+        buffer_ = static_cast<char*>(std::aligned_alloc(BlockAlignment, capacity_));
+        fd_ = openFile();
+        if (fd_ >= 0) {
+            off_t size = ::lseek(fd_, 0, SEEK_END);
+            file_size_ = size > 0 ? static_cast<std::size_t>(size) : 0;
+        }
+        if (fd_ >= 0 && buffer_ != nullptr && flush_interval_.count() > 0) {
+            flusher_ = std::thread(&BufferedFileWriter::flusherLoop, this);
+        }
+    }
+
+    BufferedFileWriter(const BufferedFileWriter&) = delete;
+    BufferedFileWriter& operator=(const BufferedFileWriter&) = delete;
+
+    ~BufferedFileWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        if (flusher_.joinable()) {
+            flusher_.join();
+        }
+        if (fd_ >= 0) {
+            sync();
+            ::close(fd_);
+        }
+        std::free(buffer_);
+    }
+
+    bool isOpen() const {
+        return fd_ >= 0 && buffer_ != nullptr;
+    }
+
+    // Добавляет строку и перевод строки; в файл уходят только полные блоки
+    void appendLine(const char* data, std::size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        copyLocked(data, size);
+        buffer_[used_++] = '\n';
+        if (used_ == capacity_) {
+            drainLocked();
+        }
+        rotateIfNeededLocked();
+    }
+
+    // Добавляет запись как есть (для двоичных форматов); ротация - только
+    // между записями
+    void append(const char* data, std::size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        copyLocked(data, size);
+        rotateIfNeededLocked();
+    }
+
+    // Отправляет буфер в файл (и на диск в надёжном режиме)
+    void sync() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        drainLocked();
+        if (durable_ && dirty_) {
+            dirty_ = false;
+            int fd = ::dup(fd_);
+            lock.unlock();
+            syncDuplicate(fd);
+        }
+    }
+
+    // Аварийный сброс из обработчика сигнала: блокировка берётся и больше не
+    // отпускается, так что фоновый поток и писатели уже не тронут буфер.
+    // Если её держит упавший поток, через timeout_ms буфер пишется как есть
+    // и последняя строка может оказаться неполной
+    void crashFlush(long timeout_ms = 50) noexcept {
+        CrashFlush::waitUntil([this] { return mutex_.try_lock(); }, timeout_ms);
+        if (fd_ >= 0 && used_ > 0) {
+            std::size_t used = used_;
+            used_ = 0;
+            writeAll(fd_, buffer_, used);
+        }
+    }
+
+    // Дескриптор текущего файла для аварийной записи (-1, если файл не открыт)
+    int descriptor() const {
+        return fd_;
+    }
+
+    // Включает ротацию; on_rotate вызывается под внутренней блокировкой
+    // и должен быстро возвращать управление
+    void enableRotation(std::size_t max_file_size, std::function<void(const std::string&)> on_rotate) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_file_size_ = max_file_size;
+        on_rotate_ = std::move(on_rotate);
+    }
+
+    // on_line вызывается под внутренней блокировкой для каждой строки (без
+    // перевода строки), уже записанной в файл, до возможной ротации, в порядке
+    // записи. Строки в буфере наблюдатель ещё не видел, поэтому, например,
+    // индекс никогда не описывает байты, которых нет на диске
+    void setLineObserver(std::function<void(const char*, std::size_t)> on_line) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        on_line_ = std::move(on_line);
+    }
+
+    // Принудительно закрывает текущий файл, если в нём есть данные
+    // (например, чтобы отдать его дальше по таймеру, а не по размеру)
+    void rotate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0 || file_size_ + used_ == 0) {
+            return;
+        }
+        drainLocked();
+        rotateLocked();
+    }
+
+    std::size_t bytesWritten() const {
+        return bytes_written_.load(std::memory_order_relaxed);
+    }
+
+    // Неудачные записи буфера в файл и строки, потерянные из-за них
+    std::size_t writeErrors() const {
+        return write_errors_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t linesLost() const {
+        return lines_lost_.load(std::memory_order_relaxed);
+    }
+
+    // errno последней неудачной записи, 0 - ошибок не было
+    int lastError() const {
+        return last_error_.load(std::memory_order_relaxed);
+    }
+};
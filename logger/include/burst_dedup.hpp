@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "log_fields.hpp"
+#include "rate_limiter.hpp"
+
+// Как сравниваются подряд идущие записи:
+// EXACT - одинаковые уровень, текст и поля (сравнение строк, без хэша);
+// TEMPLATE - одинаковые уровень и шаблон текста (числа, в том числе
+// шестнадцатеричные, не учитываются, см. KeyedRateLimiter::templateKey),
+// поля не сравниваются
+enum class DedupMode {
+    EXACT,
+    TEMPLATE
+};
+
+// Сводка по свёрнутым повторам: сколько их было и когда пришли первый и последний
+struct BurstSummary {
+    int level = 0;
+    std::uint64_t repeats = 0;
+    std::int64_t first_ns = 0;
+    std::int64_t last_ns = 0;
+    std::string last_text; // последний повтор (только в режиме TEMPLATE)
+};
+
+// Сворачивает серии одинаковых записей подряд: первая запись серии проходит,
+// повторы в течение window от неё только считаются, а вместо них выводится
+// одна сводка - когда приходит другая запись, истекает окно или вызывается
+// takePending (сброс логгера). После окна серия начинается заново, поэтому
+// на каждый шаблон приходится не больше двух записей за окно.
+// Состояние защищено мьютексом: в асинхронном режиме его берёт только
+// фоновый поток, в синхронном - потоки, вызывающие log()
+class BurstDeduplicator {
+private:
+    DedupMode mode_;
+    std::int64_t window_ns_;
+    std::mutex mutex_;
+
+    // Текущая серия
+    bool active_ = false;
+    int level_ = 0;
+    std::uint64_t key_ = 0;
+    std::string text_;
+    FieldBuffer fields_;
+    std::int64_t started_ns_ = 0;
+    BurstSummary pending_;
+
+    bool sameBurst(int level, std::uint64_t key, const std::string& text, const FieldBuffer& fields) const {
+        if (!active_ || level != level_) {
+            return false;
+        }
+        if (mode_ == DedupMode::TEMPLATE) {
+            return key == key_;
+        }
+        return text == text_ && fields == fields_;
+    }
+
+    // Переносит накопленные повторы в summary и обнуляет счётчик
+    bool takeLocked(BurstSummary& summary) {
+        if (pending_.repeats == 0) {
+            return false;
+        }
+        summary.level = level_;
+        summary.repeats = pending_.repeats;
+        summary.first_ns = pending_.first_ns;
+        summary.last_ns = pending_.last_ns;
+        summary.last_text.swap(pending_.last_text);
+        pending_.repeats = 0;
+        return true;
+    }
+
+public:
+    explicit BurstDeduplicator(DedupMode mode, std::int64_t window_ns)
+        : mode_(mode), window_ns_(window_ns) {}
+
+    // true - запись нужно передать дальше, false - это повтор, он учтён.
+    // Если перед записью нужно вывести сводку по прошлой серии, она
+    // кладётся в summary и has_summary = true
+    bool offer(int level, const std::string& text, const FieldBuffer& fields, std::int64_t now_ns,
+               BurstSummary& summary, bool& has_summary) {
+        std::uint64_t key = mode_ == DedupMode::TEMPLATE
+            ? KeyedRateLimiter::templateKey(text, static_cast<std::uint64_t>(level)) : 0;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (sameBurst(level, key, text, fields) && now_ns - started_ns_ < window_ns_) {
+            if (pending_.repeats == 0) {
+                pending_.first_ns = now_ns;
+            }
+            ++pending_.repeats;
+            pending_.last_ns = now_ns;
+            if (mode_ == DedupMode::TEMPLATE) {
+                pending_.last_text.assign(text);
+            }
+            return false;
+        }
+        has_summary = takeLocked(summary);
+        // Запись начинает новую серию
+        active_ = true;
+        level_ = level;
+        key_ = key;
+        if (mode_ == DedupMode::EXACT) {
+            text_.assign(text);
+            fields_ = fields;
+        }
+        started_ns_ = now_ns;
+        return true;
+    }
+
+    // Сводка по серии, окно которой закончилось к now_ns; серия завершается
+    bool expire(std::int64_t now_ns, BurstSummary& summary) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_ || now_ns - started_ns_ < window_ns_) {
+            return false;
+        }
+        active_ = false;
+        return takeLocked(summary);
+    }
+
+    // Сводка по уже накопленным повторам; серия продолжается
+    bool takePending(BurstSummary& summary) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return takeLocked(summary);
+    }
+};
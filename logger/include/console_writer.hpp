@@ -0,0 +1,156 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <unistd.h>
+
+#include "crash_flush.hpp"
+
+// Вывод в консоль пачками: строки копятся в буфере и уходят одним write(2)
+// раз в flush_interval (или сразу, когда набралось buffer_size байт).
+// Цвет выводится, только если дескриптор - терминал; подряд идущие строки
+// одного цвета идут под одной escape-последовательностью.
+// flush_interval = 0 - каждая строка пишется сразу
+class ConsoleWriter {
+private:
+    static constexpr std::string_view Reset = "\033[0m";
+
+    int fd_;
+    bool colored_;
+    std::size_t capacity_;
+    std::chrono::milliseconds flush_interval_;
+
+    std::mutex mutex_; // buffer_ и open_color_
+    std::string buffer_;
+    std::string_view open_color_; // цвет последней серии в buffer_
+
+    std::mutex write_mutex_; // пачки уходят в том порядке, в каком собраны
+    std::string spare_;      // пишется, пока в buffer_ копятся новые строки
+
+    std::condition_variable wakeup_;
+    bool stopping_ = false;
+    std::thread flusher_;
+
+    std::atomic<std::size_t> write_calls_{0};
+    std::atomic<std::size_t> bytes_written_{0};
+
+    // Вызывается под mutex_
+    void closeRunLocked() {
+        if (!open_color_.empty()) {
+            buffer_ += Reset;
+            open_color_ = std::string_view();
+        }
+    }
+
+    void drain() {
+        std::lock_guard<std::mutex> write_lock(write_mutex_);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (buffer_.empty()) {
+                return;
+            }
+            closeRunLocked();
+            spare_.swap(buffer_);
+        }
+        CrashWriter::writeAll(fd_, spare_.data(), spare_.size());
+        write_calls_.fetch_add(1, std::memory_order_relaxed);
+        bytes_written_.fetch_add(spare_.size(), std::memory_order_relaxed);
+        spare_.clear();
+    }
+
+    void flusherLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wakeup_.wait_for(lock, flush_interval_);
+            lock.unlock();
+            drain();
+            lock.lock();
+        }
+    }
+
+public:
+    explicit ConsoleWriter(int fd = STDOUT_FILENO,
+                           std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100),
+                           std::size_t buffer_size = 64 * 1024)
+        : fd_(fd), colored_(::isatty(fd) == 1), capacity_(buffer_size), flush_interval_(flush_interval) {
+        buffer_.reserve(capacity_);
+        spare_.reserve(capacity_);
+        if (flush_interval_.count() > 0) {
+            flusher_ = std::thread(&ConsoleWriter::flusherLoop, this);
+        }
+    }
+
+    ConsoleWriter(const ConsoleWriter&) = delete;
+    ConsoleWriter& operator=(const ConsoleWriter&) = delete;
+
+    ~ConsoleWriter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        if (flusher_.joinable()) {
+            flusher_.join();
+        }
+        drain();
+    }
+
+    bool colored() const {
+        return colored_;
+    }
+
+    // Добавляет строку и перевод строки; color - escape-последовательность
+    // цвета (пустая - без цвета), на не-терминале игнорируется
+    void append(std::string_view color, const char* data, std::size_t size) {
+        bool full;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (colored_ && color != open_color_) {
+                closeRunLocked();
+                buffer_ += color;
+                open_color_ = color;
+            }
+            buffer_.append(data, size);
+            buffer_ += '\n';
+            full = buffer_.size() >= capacity_;
+        }
+        if (full || flush_interval_.count() == 0) {
+            drain();
+        }
+    }
+
+    void flush() {
+        drain();
+    }
+
+    // Из обработчика сигнала (см. BufferedFileWriter::crashFlush): блокировка
+    // берётся навсегда, если её не держит упавший поток
+    void crashFlush(long timeout_ms = 50) noexcept {
+        CrashFlush::waitUntil([this] { return mutex_.try_lock(); }, timeout_ms);
+        if (!buffer_.empty()) {
+            CrashWriter::writeAll(fd_, buffer_.data(), buffer_.size());
+            if (!open_color_.empty()) {
+                CrashWriter::writeAll(fd_, Reset.data(), Reset.size());
+            }
+            buffer_.clear();
+        }
+    }
+
+    int descriptor() const {
+        return fd_;
+    }
+
+    std::size_t writeCalls() const {
+        return write_calls_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t bytesWritten() const {
+        return bytes_written_.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,201 @@
+#pragma once
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+// Получатель аварийного сброса. crashFlush вызывается из обработчика сигнала,
+// поэтому может использовать только async-signal-safe вызовы (write(2)),
+// не выделять память и не ждать блокировок дольше, чем waitUntil
+class CrashFlushTarget {
+public:
+    virtual void crashFlush() noexcept = 0;
+
+protected:
+    ~CrashFlushTarget() = default;
+};
+
+// Запись в дескриптор через буфер на стеке: без выделения памяти,
+// только write(2). Для аварийного пути
+class CrashWriter {
+private:
+    int fd_;
+    char buffer_[512];
+    std::size_t used_ = 0;
+
+public:
+    explicit CrashWriter(int fd) : fd_(fd) {}
+
+    CrashWriter(const CrashWriter&) = delete;
+    CrashWriter& operator=(const CrashWriter&) = delete;
+
+    ~CrashWriter() {
+        flush();
+    }
+
+    static void writeAll(int fd, const char* data, std::size_t size) noexcept {
+        while (size > 0) {
+            ssize_t written = ::write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return;
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+
+    void put(char c) noexcept {
+        if (used_ == sizeof(buffer_)) {
+            flush();
+        }
+        buffer_[used_++] = c;
+    }
+
+    void put(const char* data, std::size_t size) noexcept {
+        for (std::size_t i = 0; i < size; ++i) {
+            put(data[i]);
+        }
+    }
+
+    void put(const char* text) noexcept {
+        put(text, std::strlen(text));
+    }
+
+    // Строка JSON в кавычках
+    void putJsonString(const char* data, std::size_t size) noexcept {
+        static const char hex[] = "0123456789abcdef";
+        put('"');
+        for (std::size_t i = 0; i < size; ++i) {
+            unsigned char byte = static_cast<unsigned char>(data[i]);
+            if (byte == '"' || byte == '\\') {
+                put('\\');
+                put(data[i]);
+            } else if (byte < 0x20) {
+                put("\\u00", 4);
+                put(hex[byte >> 4]);
+                put(hex[byte & 0x0F]);
+            } else {
+                put(data[i]);
+            }
+        }
+        put('"');
+    }
+
+    void flush() noexcept {
+        writeAll(fd_, buffer_, used_);
+        used_ = 0;
+    }
+};
+
+// Аварийный сброс при SIGSEGV, SIGBUS, SIGFPE, SIGILL и SIGABRT: обработчик
+// вызывает crashFlush у всех зарегистрированных получателей, восстанавливает
+// прежнее действие для сигнала и посылает сигнал повторно, так что процесс
+// завершается как обычно (с core dump). На обычном пути ничего не стоит:
+// регистрация - запись указателя в фиксированную таблицу.
+// Переполнение стека обрабатывается на отдельном стеке только в потоке,
+// вызвавшем install()
+class CrashFlush {
+private:
+    static constexpr std::size_t MaxTargets = 16;
+    static constexpr int Signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+    static constexpr std::size_t SignalCount = sizeof(Signals) / sizeof(Signals[0]);
+    static constexpr std::size_t AltStackSize = 64 * 1024;
+
+    inline static std::atomic<CrashFlushTarget*> targets_[MaxTargets] = {};
+    inline static struct sigaction previous_[SignalCount] = {};
+    inline static std::atomic<bool> flushing_{false};
+    inline static std::once_flag installed_;
+    inline static char alt_stack_[AltStackSize];
+
+    static void handleSignal(int signal_number, siginfo_t*, void*) {
+        // Повторный сбой во время сброса не должен зациклиться
+        if (!flushing_.exchange(true)) {
+            for (auto& slot : targets_) {
+                CrashFlushTarget* target = slot.load(std::memory_order_acquire);
+                if (target != nullptr) {
+                    target->crashFlush();
+                }
+            }
+        }
+        for (std::size_t i = 0; i < SignalCount; ++i) {
+            if (Signals[i] == signal_number) {
+                ::sigaction(signal_number, &previous_[i], nullptr);
+            }
+        }
+        // Сигнал заблокирован до выхода из обработчика, после него сработает
+        // прежнее действие
+        ::raise(signal_number);
+    }
+
+    static void installHandlers() {
+        stack_t current;
+        if (::sigaltstack(nullptr, &current) == 0 && (current.ss_flags & SS_ONSTACK) == 0 &&
+            current.ss_sp == nullptr) {
+            stack_t alternate{};
+            alternate.ss_sp = alt_stack_;
+            alternate.ss_size = AltStackSize;
+            ::sigaltstack(&alternate, nullptr);
+        }
+        struct sigaction action{};
+        action.sa_sigaction = &CrashFlush::handleSignal;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (std::size_t i = 0; i < SignalCount; ++i) {
+            ::sigaction(Signals[i], &action, &previous_[i]);
+        }
+    }
+
+public:
+    // Ждёт, пока done() не вернёт true, но не дольше timeout_ms; только
+    // clock_gettime и nanosleep, поэтому годится для обработчика сигнала
+    template<typename F>
+    static bool waitUntil(F&& done, long timeout_ms) noexcept {
+        timespec start;
+        ::clock_gettime(CLOCK_MONOTONIC, &start);
+        for (;;) {
+            if (done()) {
+                return true;
+            }
+            timespec now;
+            ::clock_gettime(CLOCK_MONOTONIC, &now);
+            long elapsed_ms = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+            if (elapsed_ms >= timeout_ms) {
+                return false;
+            }
+            timespec pause{0, 100000};
+            ::nanosleep(&pause, nullptr);
+        }
+    }
+
+    // Ставит обработчики сигналов (один раз на процесс)
+    static void install() {
+        std::call_once(installed_, &CrashFlush::installHandlers);
+    }
+
+    // false - таблица заполнена
+    static bool add(CrashFlushTarget* target) {
+        for (auto& slot : targets_) {
+            CrashFlushTarget* empty = nullptr;
+            if (slot.compare_exchange_strong(empty, target, std::memory_order_acq_rel)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void remove(CrashFlushTarget* target) {
+        for (auto& slot : targets_) {
+            CrashFlushTarget* expected = target;
+            slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+        }
+    }
+};
@@ -0,0 +1,272 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Строки формата в стиле "user {} took {} us", разбираемые на этапе компиляции.
+// Подстановки: {} - любое значение, {:d} - целое, {:x} - целое в hex,
+// {:s} - строка, {:.Nf} - число с N знаками после точки (N от 0 до 9);
+// "{{" и "}}" - фигурные скобки. Разбор превращает строку в массив операций
+// (кусок текста или аргумент), поэтому при выводе строка не анализируется.
+enum class FormatSpec : char {
+    ANY,
+    DECIMAL,
+    HEX,
+    STRING,
+    FIXED
+};
+
+struct FormatOp {
+    bool is_argument = false;
+    std::size_t begin = 0;  // кусок текста: смещение в строке формата
+    std::size_t length = 0;
+    FormatSpec spec = FormatSpec::ANY;
+    int precision = 0;
+};
+
+// Результат разбора строки формата с Ops операциями
+template<std::size_t Ops>
+struct ParsedFormat {
+    FormatOp ops[Ops > 0 ? Ops : 1] = {};
+    std::size_t arguments = 0;
+};
+
+class FormatString {
+private:
+    // Разбирает подстановку, начинающуюся с '{' в позиции pos.
+    // Возвращает позицию после '}' или 0 при ошибке
+    static constexpr std::size_t parseField(std::string_view format, std::size_t pos, FormatOp& op) {
+        op = FormatOp{};
+        op.is_argument = true;
+        std::size_t i = pos + 1;
+        if (i < format.size() && format[i] == ':') {
+            ++i;
+            if (i < format.size() && format[i] == 'd') {
+                op.spec = FormatSpec::DECIMAL;
+                ++i;
+            } else if (i < format.size() && format[i] == 'x') {
+                op.spec = FormatSpec::HEX;
+                ++i;
+            } else if (i < format.size() && format[i] == 's') {
+                op.spec = FormatSpec::STRING;
+                ++i;
+            } else if (i + 2 < format.size() && format[i] == '.' &&
+                       format[i + 1] >= '0' && format[i + 1] <= '9' && format[i + 2] == 'f') {
+                op.spec = FormatSpec::FIXED;
+                op.precision = format[i + 1] - '0';
+                i += 3;
+            } else {
+                return 0;
+            }
+        }
+        if (i >= format.size() || format[i] != '}') {
+            return 0;
+        }
+        return i + 1;
+    }
+
+    struct Counter {
+        std::size_t* ops;
+        std::size_t* arguments;
+        constexpr void operator()(const FormatOp& op) const {
+            ++*ops;
+            if (op.is_argument) {
+                ++*arguments;
+            }
+        }
+    };
+
+    template<std::size_t Ops>
+    struct Filler {
+        ParsedFormat<Ops>* parsed;
+        std::size_t* next;
+        constexpr void operator()(const FormatOp& op) const {
+            parsed->ops[(*next)++] = op;
+            if (op.is_argument) {
+                ++parsed->arguments;
+            }
+        }
+    };
+
+    template<typename T>
+    static void appendInteger(std::string& out, T value, int base) {
+        char digits[72];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value, base);
+        out.append(digits, static_cast<std::size_t>(result.ptr - digits));
+    }
+
+public:
+    // Обходит строку; для каждой операции вызывает emit(op).
+    // false - строка формата некорректна
+    template<typename Emit>
+    static constexpr bool walk(std::string_view format, Emit&& emit) {
+        std::size_t literal_begin = 0;
+        std::size_t i = 0;
+        while (i < format.size()) {
+            char c = format[i];
+            if (c != '{' && c != '}') {
+                ++i;
+                continue;
+            }
+            bool escaped = i + 1 < format.size() && format[i + 1] == c;
+            if (!escaped && c == '}') {
+                return false; // одиночная '}'
+            }
+            // Текст до скобки; для "{{" в него входит одна скобка
+            std::size_t literal_end = escaped ? i + 1 : i;
+            if (literal_end > literal_begin) {
+                FormatOp literal;
+                literal.begin = literal_begin;
+                literal.length = literal_end - literal_begin;
+                emit(literal);
+            }
+            if (escaped) {
+                i += 2;
+            } else {
+                FormatOp argument;
+                i = parseField(format, i, argument);
+                if (i == 0) {
+                    return false;
+                }
+                emit(argument);
+            }
+            literal_begin = i;
+        }
+        if (format.size() > literal_begin) {
+            FormatOp literal;
+            literal.begin = literal_begin;
+            literal.length = format.size() - literal_begin;
+            emit(literal);
+        }
+        return true;
+    }
+
+    static constexpr bool isValid(std::string_view format) {
+        return walk(format, [](const FormatOp&) {});
+    }
+
+    static constexpr std::size_t opCount(std::string_view format) {
+        std::size_t ops = 0;
+        std::size_t arguments = 0;
+        walk(format, Counter{&ops, &arguments});
+        return ops;
+    }
+
+    static constexpr std::size_t argumentCount(std::string_view format) {
+        std::size_t ops = 0;
+        std::size_t arguments = 0;
+        walk(format, Counter{&ops, &arguments});
+        return arguments;
+    }
+
+    template<std::size_t Ops>
+    static constexpr ParsedFormat<Ops> parse(std::string_view format) {
+        ParsedFormat<Ops> parsed{};
+        std::size_t next = 0;
+        walk(format, Filler<Ops>{&parsed, &next});
+        return parsed;
+    }
+
+    // Подходит ли тип аргумента к подстановке
+    template<typename T>
+    static constexpr bool accepts(FormatSpec spec) {
+        using Type = std::decay_t<T>;
+        constexpr bool is_bool = std::is_same_v<Type, bool>;
+        constexpr bool is_char = std::is_same_v<Type, char>;
+        constexpr bool is_integer = std::is_integral_v<Type> && !is_bool && !is_char;
+        constexpr bool is_string = std::is_convertible_v<const T&, std::string_view>;
+        constexpr bool is_number = is_integer || std::is_floating_point_v<Type> || std::is_enum_v<Type>;
+        switch (spec) {
+            case FormatSpec::ANY: return is_bool || is_char || is_number || is_string || std::is_pointer_v<Type>;
+            case FormatSpec::DECIMAL: return is_integer || std::is_enum_v<Type>;
+            case FormatSpec::HEX: return is_integer || std::is_enum_v<Type> || std::is_pointer_v<Type>;
+            case FormatSpec::STRING: return is_string;
+            case FormatSpec::FIXED: return std::is_floating_point_v<Type>;
+        }
+        return false;
+    }
+
+    // Проверяет типы всех аргументов по порядку подстановок
+    template<std::size_t Ops, typename... Args>
+    static constexpr bool argumentsMatch(const ParsedFormat<Ops>& parsed) {
+        FormatSpec specs[sizeof...(Args) > 0 ? sizeof...(Args) : 1] = {};
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < Ops; ++i) {
+            if (parsed.ops[i].is_argument && count < sizeof...(Args)) {
+                specs[count++] = parsed.ops[i].spec;
+            }
+        }
+        std::size_t index = 0;
+        return (accepts<Args>(specs[index++]) && ...);
+    }
+
+    template<typename T>
+    static void appendValue(std::string& out, const T& value, const FormatOp& op) {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, bool>) {
+            out += value ? "true" : "false";
+        } else if constexpr (std::is_same_v<Type, char>) {
+            out += value;
+        } else if constexpr (std::is_enum_v<Type>) {
+            appendValue(out, static_cast<std::underlying_type_t<Type>>(value), op);
+        } else if constexpr (std::is_integral_v<Type>) {
+            if (op.spec == FormatSpec::HEX) {
+                using Unsigned = std::make_unsigned_t<Type>;
+                appendInteger(out, static_cast<Unsigned>(value), 16);
+            } else {
+                appendInteger(out, value, 10);
+            }
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            char number[64];
+            int length = op.spec == FormatSpec::FIXED
+                ? std::snprintf(number, sizeof(number), "%.*f", op.precision, static_cast<double>(value))
+                : std::snprintf(number, sizeof(number), "%.15g", static_cast<double>(value));
+            if (length > 0) {
+                out.append(number, std::min(static_cast<std::size_t>(length), sizeof(number) - 1));
+            }
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            if constexpr (std::is_pointer_v<T>) {
+                out += value != nullptr ? std::string_view(value) : std::string_view("(null)");
+            } else {
+                out += std::string_view(value);
+            }
+        } else {
+            out += "0x";
+            appendInteger(out, reinterpret_cast<std::uintptr_t>(value), 16);
+        }
+    }
+
+    // Проверки строки формата для места вызова (Logger::logFormat, logDeferred):
+    // source - лямбда без захвата, возвращающая строковый литерал
+    template<typename... Args, typename FormatSource>
+    static constexpr bool check(FormatSource source) {
+        constexpr std::string_view format = source();
+        static_assert(isValid(format), "malformed format string");
+        static_assert(argumentCount(format) == sizeof...(Args),
+                      "number of arguments does not match the placeholders");
+        static_assert(argumentsMatch<opCount(format), Args...>(parse<opCount(format)>(format)),
+                      "argument type does not match its placeholder");
+        return true;
+    }
+
+    // Вывод по заранее разобранной строке: куски текста копируются,
+    // аргументы подставляются по порядку
+    template<std::size_t Ops, typename... Args>
+    static void render(std::string& out, std::string_view format,
+                       const ParsedFormat<Ops>& parsed, const Args&... args) {
+        std::size_t op = 0;
+        auto appendLiterals = [&]() {
+            while (op < Ops && !parsed.ops[op].is_argument) {
+                out.append(format.data() + parsed.ops[op].begin, parsed.ops[op].length);
+                ++op;
+            }
+        };
+        appendLiterals();
+        ((appendValue(out, args, parsed.ops[op++]), appendLiterals()), ...);
+    }
+};
@@ -0,0 +1,339 @@
+#pragma once
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// Уровни по именам модулей: "net = WARN", "net.http = DEBUG". Уровень модуля
+// наследуется от ближайшего настроенного предка по точкам (net.http.client ->
+// net.http -> net -> root). Числа уровней совпадают с порядком LogLevel,
+// OFF (4) выключает модуль целиком. Снимок после создания не меняется
+struct LevelSnapshot {
+    static constexpr int Unset = -1;
+    static constexpr int Off = 4;
+
+    int root = Unset;
+    std::vector<std::pair<std::string, int>> levels;
+
+    // Уровень модуля или fallback, если ни он, ни предки не настроены
+    int resolve(std::string_view name, int fallback) const {
+        for (;;) {
+            if (name.empty()) {
+                return root != Unset ? root : fallback;
+            }
+            for (const auto& entry : levels) {
+                if (entry.first == name) {
+                    return entry.second;
+                }
+            }
+            std::size_t dot = name.rfind('.');
+            name = dot == std::string_view::npos ? std::string_view() : name.substr(0, dot);
+        }
+    }
+
+    void set(const std::string& name, int level) {
+        if (name.empty() || name == "root") {
+            root = level;
+            return;
+        }
+        for (auto& entry : levels) {
+            if (entry.first == name) {
+                entry.second = level;
+                return;
+            }
+        }
+        levels.emplace_back(name, level);
+    }
+
+    static int parseLevel(std::string_view text) {
+        std::string upper;
+        for (char c : text) {
+            upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+        if (upper == "DEBUG") {
+            return 0;
+        }
+        if (upper == "INFO") {
+            return 1;
+        }
+        if (upper == "WARN" || upper == "WARNING") {
+            return 2;
+        }
+        if (upper == "ERROR") {
+            return 3;
+        }
+        if (upper == "OFF") {
+            return Off;
+        }
+        return Unset;
+    }
+
+    // Строки "имя = УРОВЕНЬ", '#' - комментарий, "root" - корневой логгер.
+    // При ошибке снимок не меняется, в error - номер строки и причина
+    static bool parse(const std::string& text, LevelSnapshot& out, std::string& error) {
+        LevelSnapshot parsed;
+        std::istringstream input(text);
+        std::string line;
+        int line_number = 0;
+        auto trim = [](std::string_view value) {
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) {
+                value.remove_prefix(1);
+            }
+            while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+                value.remove_suffix(1);
+            }
+            return value;
+        };
+        while (std::getline(input, line)) {
+            ++line_number;
+            std::string_view content = line;
+            content = trim(content.substr(0, content.find('#')));
+            if (content.empty()) {
+                continue;
+            }
+            std::size_t equals = content.find('=');
+            if (equals == std::string_view::npos) {
+                error = "line " + std::to_string(line_number) + ": expected 'name = LEVEL'";
+                return false;
+            }
+            std::string_view name = trim(content.substr(0, equals));
+            int level = parseLevel(trim(content.substr(equals + 1)));
+            if (name.empty() || level == Unset) {
+                error = "line " + std::to_string(line_number) + ": bad module name or level";
+                return false;
+            }
+            parsed.set(std::string(name), level);
+        }
+        out = std::move(parsed);
+        return true;
+    }
+};
+
+// Следит за файлом и вызывает on_change после каждой его записи или замены.
+// На Linux - inotify на каталог (редакторы сохраняют файл через rename),
+// на других системах - проверка времени изменения раз в секунду
+class ConfigWatcher {
+private:
+    std::filesystem::path path_;
+    std::function<void()> on_change_;
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+#ifdef __linux__
+    int inotify_fd_ = -1;
+    int wake_pipe_[2] = {-1, -1};
+#else
+    std::mutex mutex_;
+    std::condition_variable wake_;
+#endif
+
+#ifdef __linux__
+    void watchLoop() {
+        std::string file_name = path_.filename().string();
+        alignas(inotify_event) char buffer[4096];
+        pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_pipe_[0], POLLIN, 0}};
+        while (!stopping_.load(std::memory_order_acquire)) {
+            if (::poll(fds, 2, -1) < 0) {
+                continue; // EINTR
+            }
+            if (fds[1].revents != 0) {
+                return;
+            }
+            ssize_t length = ::read(inotify_fd_, buffer, sizeof(buffer));
+            bool changed = false;
+            for (ssize_t offset = 0; offset < length;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+                if (event->len > 0 && file_name == event->name) {
+                    changed = true;
+                }
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            }
+            if (changed) {
+                on_change_();
+            }
+        }
+    }
+#else
+    void watchLoop() {
+        std::error_code error;
+        auto last = std::filesystem::last_write_time(path_, error);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_.load(std::memory_order_acquire)) {
+            wake_.wait_for(lock, std::chrono::seconds(1));
+            auto current = std::filesystem::last_write_time(path_, error);
+            if (!error && current != last) {
+                last = current;
+                lock.unlock();
+                on_change_();
+                lock.lock();
+            }
+        }
+    }
+#endif
+
+public:
+    ConfigWatcher(const std::string& path, std::function<void()> on_change)
+        : path_(path), on_change_(std::move(on_change)) {
+#ifdef __linux__
+        std::filesystem::path directory = path_.parent_path();
+        if (directory.empty()) {
+            directory = ".";
+        }
+        inotify_fd_ = ::inotify_init1(IN_CLOEXEC);
+        if (inotify_fd_ < 0 || ::pipe2(wake_pipe_, O_CLOEXEC) != 0 ||
+            ::inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+            return; // следить не получится, уровни останутся как есть
+        }
+#endif
+        thread_ = std::thread(&ConfigWatcher::watchLoop, this);
+    }
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    ~ConfigWatcher() {
+        stopping_.store(true, std::memory_order_release);
+#ifdef __linux__
+        if (wake_pipe_[1] >= 0) {
+            char byte = 0;
+            ssize_t written = ::write(wake_pipe_[1], &byte, 1);
+            (void)written;
+        }
+#else
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+        wake_.notify_all();
+#endif
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+#ifdef __linux__
+        for (int fd : {inotify_fd_, wake_pipe_[0], wake_pipe_[1]}) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+#endif
+    }
+
+    bool watching() const {
+        return thread_.joinable();
+    }
+};
+
+// Уровни именованных логгеров. Каждый логгер регистрирует свой атомарный
+// уровень; новая конфигурация собирается в отдельный снимок, публикуется
+// атомарной заменой указателя, после чего уровни логгеров пересчитываются.
+// Логирующие потоки читают только свой атомарный уровень - без блокировок.
+// Старые снимки не освобождаются (их может читать levelFor); конфигурация
+// меняется редко, так что память не растёт заметно
+class LevelRegistry {
+private:
+    struct Node {
+        std::string name;
+        std::atomic<int>* level;
+    };
+
+    std::mutex mutex_; // изменения конфигурации и регистрация логгеров
+    std::vector<Node> nodes_;
+    std::vector<std::unique_ptr<LevelSnapshot>> snapshots_;
+    std::atomic<const LevelSnapshot*> current_;
+    int default_level_;
+    std::unique_ptr<ConfigWatcher> watcher_;
+
+    void publishLocked(std::unique_ptr<LevelSnapshot> snapshot) {
+        current_.store(snapshot.get(), std::memory_order_release);
+        for (const auto& node : nodes_) {
+            node.level->store(snapshot->resolve(node.name, default_level_), std::memory_order_relaxed);
+        }
+        snapshots_.push_back(std::move(snapshot));
+    }
+
+public:
+    // default_level - уровень, если не настроены ни модуль, ни root
+    explicit LevelRegistry(int default_level) : default_level_(default_level) {
+        snapshots_.push_back(std::make_unique<LevelSnapshot>());
+        current_.store(snapshots_.back().get(), std::memory_order_release);
+    }
+
+    LevelRegistry(const LevelRegistry&) = delete;
+    LevelRegistry& operator=(const LevelRegistry&) = delete;
+
+    ~LevelRegistry() {
+        watcher_.reset(); // поток наблюдателя обращается к реестру
+    }
+
+    // Регистрирует уровень логгера name ("" - корневой) и сразу его выставляет;
+    // level должен жить дольше реестра
+    void attach(const std::string& name, std::atomic<int>* level) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nodes_.push_back({name, level});
+        level->store(current_.load(std::memory_order_acquire)->resolve(name, default_level_),
+                     std::memory_order_relaxed);
+    }
+
+    int levelFor(std::string_view name) const {
+        return current_.load(std::memory_order_acquire)->resolve(name, default_level_);
+    }
+
+    // Заменяет конфигурацию целиком
+    void apply(const LevelSnapshot& snapshot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        publishLocked(std::make_unique<LevelSnapshot>(snapshot));
+    }
+
+    // Меняет уровень одного модуля, остальное берётся из текущего снимка
+    void set(const std::string& name, int level) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto snapshot = std::make_unique<LevelSnapshot>(*current_.load(std::memory_order_acquire));
+        snapshot->set(name, level);
+        publishLocked(std::move(snapshot));
+    }
+
+    // Читает файл конфигурации; при ошибке действующие уровни не меняются
+    bool load(const std::string& path, std::string& error) {
+        std::ifstream file(path);
+        if (!file) {
+            error = "cannot open " + path;
+            return false;
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        LevelSnapshot snapshot;
+        if (!LevelSnapshot::parse(content.str(), snapshot, error)) {
+            error = path + ": " + error;
+            return false;
+        }
+        apply(snapshot);
+        return true;
+    }
+
+    // Перечитывает файл при каждом изменении; ошибки передаются в on_error
+    void watch(const std::string& path, std::function<void(const std::string&)> on_error) {
+        watcher_.reset();
+        watcher_ = std::make_unique<ConfigWatcher>(path, [this, path, on_error]() {
+            std::string error;
+            if (!load(path, error) && on_error) {
+                on_error(error);
+            }
+        });
+    }
+};
@@ -0,0 +1,327 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Тип значения поля структурированной записи
+enum class FieldType : std::uint8_t {
+    INT,
+    UINT,
+    DOUBLE,
+    BOOL,
+    STRING
+};
+
+// Поле записи: ключ и типизированное значение. Только ссылается на ключ и
+// строковое значение, поэтому живёт не дольше вызова log() и нужно лишь для
+// передачи полей в FieldBuffer:
+//   logger.log(LogLevel::INFO, "request done", {{"user_id", 42}, {"latency_us", 1.3}});
+struct LogField {
+    std::string_view key;
+    FieldType type = FieldType::INT;
+    std::int64_t int_value = 0;
+    std::uint64_t uint_value = 0;
+    double double_value = 0.0;
+    bool bool_value = false;
+    std::string_view string_value;
+
+    LogField() = default;
+
+    template<typename T>
+    LogField(std::string_view field_key, const T& value) : key(field_key) {
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, bool>) {
+            type = FieldType::BOOL;
+            bool_value = value;
+        } else if constexpr (std::is_integral_v<Type> && std::is_signed_v<Type>) {
+            type = FieldType::INT;
+            int_value = value;
+        } else if constexpr (std::is_integral_v<Type>) {
+            type = FieldType::UINT;
+            uint_value = value;
+        } else if constexpr (std::is_floating_point_v<Type>) {
+            type = FieldType::DOUBLE;
+            double_value = static_cast<double>(value);
+        } else if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+            type = FieldType::STRING;
+            string_value = value;
+        } else {
+            static_assert(std::is_convertible_v<const T&, std::string_view>,
+                          "field value must be a number, bool or string");
+        }
+    }
+
+    // Числа разных типов сравниваются по значению; -1, 0, 1 или 2 (несравнимы)
+    int compare(const LogField& other) const {
+        auto order = [](auto a, auto b) { return a < b ? -1 : (b < a ? 1 : 0); };
+        bool numeric = type != FieldType::BOOL && type != FieldType::STRING;
+        bool other_numeric = other.type != FieldType::BOOL && other.type != FieldType::STRING;
+        if (numeric && other_numeric) {
+            if (type == FieldType::INT && other.type == FieldType::INT) {
+                return order(int_value, other.int_value);
+            }
+            if (type == FieldType::UINT && other.type == FieldType::UINT) {
+                return order(uint_value, other.uint_value);
+            }
+            double a = asDouble();
+            double b = other.asDouble();
+            if (std::isnan(a) || std::isnan(b)) {
+                return 2;
+            }
+            return order(a, b);
+        }
+        if (type != other.type) {
+            return 2;
+        }
+        if (type == FieldType::BOOL) {
+            return order(bool_value, other.bool_value);
+        }
+        int result = string_value.compare(other.string_value);
+        return order(result, 0);
+    }
+
+    double asDouble() const {
+        switch (type) {
+            case FieldType::INT: return static_cast<double>(int_value);
+            case FieldType::UINT: return static_cast<double>(uint_value);
+            case FieldType::DOUBLE: return double_value;
+            case FieldType::BOOL: return bool_value ? 1.0 : 0.0;
+            default: return 0.0;
+        }
+    }
+};
+
+// Компактное двоичное представление полей фиксированной ёмкости, хранится
+// прямо в записи (без выделения памяти). Формат поля:
+// [тип: 1 байт][длина ключа: 1 байт][ключ][значение]; значение - 8 байт для
+// чисел, 1 байт для bool, [длина: 2 байта][байты] для строк.
+// Поля, которые не поместились, отбрасываются (длинная строка - обрезается),
+// truncated() это показывает.
+class FieldBuffer {
+public:
+    static constexpr std::size_t Capacity = 192;
+
+private:
+    char data_[Capacity];
+    std::uint16_t size_ = 0;
+    bool truncated_ = false;
+
+    void put(const void* bytes, std::size_t length) {
+        std::memcpy(data_ + size_, bytes, length);
+        size_ = static_cast<std::uint16_t>(size_ + length);
+    }
+
+    static void appendDouble(std::string& out, double value) {
+        char number[32];
+        int length = std::snprintf(number, sizeof(number), "%.15g", value);
+        out.append(number, static_cast<std::size_t>(length));
+    }
+
+    static void appendValue(std::string& out, const LogField& field) {
+        switch (field.type) {
+            case FieldType::INT: out += std::to_string(field.int_value); break;
+            case FieldType::UINT: out += std::to_string(field.uint_value); break;
+            case FieldType::DOUBLE: appendDouble(out, field.double_value); break;
+            case FieldType::BOOL: out += field.bool_value ? "true" : "false"; break;
+            case FieldType::STRING: out += field.string_value; break;
+        }
+    }
+
+public:
+    FieldBuffer() = default;
+
+    // Копируется только занятая часть буфера
+    FieldBuffer(const FieldBuffer& other) : size_(other.size_), truncated_(other.truncated_) {
+        std::memcpy(data_, other.data_, size_);
+    }
+
+    FieldBuffer& operator=(const FieldBuffer& other) {
+        size_ = other.size_;
+        truncated_ = other.truncated_;
+        std::memmove(data_, other.data_, size_);
+        return *this;
+    }
+
+    // Побайтовое сравнение закодированных полей
+    bool operator==(const FieldBuffer& other) const {
+        return size_ == other.size_ && std::memcmp(data_, other.data_, size_) == 0;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    bool truncated() const {
+        return truncated_;
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    void clear() {
+        size_ = 0;
+        truncated_ = false;
+    }
+
+    void add(const LogField& field) {
+        std::size_t key_length = field.key.size() < 255 ? field.key.size() : 255;
+        std::size_t header = 2 + key_length;
+        std::size_t value_length = 8;
+        std::size_t string_length = 0;
+        if (field.type == FieldType::BOOL) {
+            value_length = 1;
+        } else if (field.type == FieldType::STRING) {
+            std::size_t room = Capacity - size_;
+            string_length = field.string_value.size();
+            if (room < header + 2) {
+                string_length = 0;
+            } else if (string_length > room - header - 2) {
+                string_length = room - header - 2;
+                truncated_ = true;
+            }
+            value_length = 2 + string_length;
+        }
+        if (size_ + header + value_length > Capacity) {
+            truncated_ = true;
+            return;
+        }
+        std::uint8_t prefix[2] = {static_cast<std::uint8_t>(field.type), static_cast<std::uint8_t>(key_length)};
+        put(prefix, 2);
+        put(field.key.data(), key_length);
+        switch (field.type) {
+            case FieldType::INT: put(&field.int_value, 8); break;
+            case FieldType::UINT: put(&field.uint_value, 8); break;
+            case FieldType::DOUBLE: put(&field.double_value, 8); break;
+            case FieldType::BOOL: {
+                std::uint8_t flag = field.bool_value ? 1 : 0;
+                put(&flag, 1);
+                break;
+            }
+            case FieldType::STRING: {
+                std::uint16_t length = static_cast<std::uint16_t>(string_length);
+                put(&length, 2);
+                put(field.string_value.data(), string_length);
+                break;
+            }
+        }
+    }
+
+    // Вызывает visit(const LogField&) для каждого поля; строки и ключи
+    // ссылаются на память буфера
+    template<typename Visitor>
+    void forEach(Visitor&& visit) const {
+        std::size_t offset = 0;
+        while (offset + 2 <= size_) {
+            LogField field;
+            field.type = static_cast<FieldType>(static_cast<std::uint8_t>(data_[offset]));
+            std::size_t key_length = static_cast<std::uint8_t>(data_[offset + 1]);
+            field.key = std::string_view(data_ + offset + 2, key_length);
+            offset += 2 + key_length;
+            switch (field.type) {
+                case FieldType::INT: std::memcpy(&field.int_value, data_ + offset, 8); offset += 8; break;
+                case FieldType::UINT: std::memcpy(&field.uint_value, data_ + offset, 8); offset += 8; break;
+                case FieldType::DOUBLE: std::memcpy(&field.double_value, data_ + offset, 8); offset += 8; break;
+                case FieldType::BOOL: field.bool_value = data_[offset] != 0; offset += 1; break;
+                case FieldType::STRING: {
+                    std::uint16_t length;
+                    std::memcpy(&length, data_ + offset, 2);
+                    field.string_value = std::string_view(data_ + offset + 2, length);
+                    offset += 2 + length;
+                    break;
+                }
+            }
+            visit(static_cast<const LogField&>(field));
+        }
+    }
+
+    // Ищет первое поле с ключом key
+    bool find(std::string_view key, LogField& out) const {
+        bool found = false;
+        forEach([&](const LogField& field) {
+            if (!found && field.key == key) {
+                out = field;
+                found = true;
+            }
+        });
+        return found;
+    }
+
+    // " key=value key2=value2"; строки с пробелами, переводами строк, '"' или '='
+    // берутся в кавычки
+    void appendText(std::string& out) const {
+        forEach([&out](const LogField& field) {
+            out += ' ';
+            out += field.key;
+            out += '=';
+            if (field.type == FieldType::STRING &&
+                (field.string_value.empty() || field.string_value.find_first_of(" \t\r\n\"=") != std::string_view::npos)) {
+                out += '"';
+                for (char c : field.string_value) {
+                    if (c == '\n') {
+                        out += "\\n"; // запись остаётся одной строкой
+                    } else if (c == '\r') {
+                        out += "\\r";
+                    } else {
+                        if (c == '"' || c == '\\') {
+                            out += '\\';
+                        }
+                        out += c;
+                    }
+                }
+                out += '"';
+            } else {
+                appendValue(out, field);
+            }
+        });
+    }
+
+    // Члены JSON-объекта без скобок: "key":value,"key2":value2
+    void appendJson(std::string& out) const {
+        bool first = true;
+        forEach([&](const LogField& field) {
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            appendJsonString(out, field.key);
+            out += ':';
+            if (field.type == FieldType::STRING) {
+                appendJsonString(out, field.string_value);
+            } else if (field.type == FieldType::DOUBLE && !std::isfinite(field.double_value)) {
+                out += "null"; // в JSON нет NaN и бесконечностей
+            } else {
+                appendValue(out, field);
+            }
+        });
+    }
+
+    static void appendJsonString(std::string& out, std::string_view text) {
+        static const char hex[] = "0123456789abcdef";
+        out += '"';
+        for (char c : text) {
+            unsigned char byte = static_cast<unsigned char>(c);
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if (byte < 0x20) {
+                        out += "\\u00";
+                        out += hex[byte >> 4];
+                        out += hex[byte & 0x0F];
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        out += '"';
+    }
+};
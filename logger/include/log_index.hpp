@@ -0,0 +1,374 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Разбор начала строки в формате TimestampFormatter:
+// "[LEVEL] [YYYY.MM.DD HH:MM:SS.fff] текст" (дробная часть любой длины).
+// Местное время переводится в секунды через mktime раз в секунду журнала:
+// часть до секунд сравнивается с прошлой строкой
+class LogLineParser {
+public:
+    static constexpr int UnknownLevel = 7; // строка без заголовка
+    static constexpr std::size_t StampLength = 19; // "YYYY.MM.DD HH:MM:SS"
+
+private:
+    char cached_stamp_[StampLength] = {};
+    std::int64_t cached_seconds_ = -1;
+
+    static bool digits(const char* text, std::size_t count, int& value) {
+        value = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            if (text[i] < '0' || text[i] > '9') {
+                return false;
+            }
+            value = value * 10 + (text[i] - '0');
+        }
+        return true;
+    }
+
+public:
+    // Номера уровней совпадают с порядком LogLevel
+    static int levelFromName(std::string_view name) {
+        static const char* const names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+        for (int i = 0; i < 4; ++i) {
+            if (name == names[i]) {
+                return i;
+            }
+        }
+        return UnknownLevel;
+    }
+
+    // Секунды от эпохи для "YYYY.MM.DD HH:MM:SS" по местному времени; -1 при ошибке
+    std::int64_t secondsFor(const char* stamp) {
+        if (cached_seconds_ >= 0 && std::memcmp(stamp, cached_stamp_, StampLength) == 0) {
+            return cached_seconds_;
+        }
+        int year, month, day, hour, minute, second;
+        if (!digits(stamp, 4, year) || stamp[4] != '.' || !digits(stamp + 5, 2, month) || stamp[7] != '.' ||
+            !digits(stamp + 8, 2, day) || stamp[10] != ' ' || !digits(stamp + 11, 2, hour) || stamp[13] != ':' ||
+            !digits(stamp + 14, 2, minute) || stamp[16] != ':' || !digits(stamp + 17, 2, second)) {
+            return -1;
+        }
+        std::tm parts{};
+        parts.tm_year = year - 1900;
+        parts.tm_mon = month - 1;
+        parts.tm_mday = day;
+        parts.tm_hour = hour;
+        parts.tm_min = minute;
+        parts.tm_sec = second;
+        parts.tm_isdst = -1;
+        std::time_t seconds = std::mktime(&parts);
+        if (seconds < 0) {
+            return -1;
+        }
+        std::memcpy(cached_stamp_, stamp, StampLength);
+        cached_seconds_ = static_cast<std::int64_t>(seconds);
+        return cached_seconds_;
+    }
+
+    // false - у строки нет заголовка с уровнем и временем (level и ms не меняются)
+    bool parse(const char* line, std::size_t size, int& level, std::int64_t& ms) {
+        if (size < 2 || line[0] != '[') {
+            return false;
+        }
+        const char* close = static_cast<const char*>(std::memchr(line, ']', size < 8 ? size : 8));
+        if (close == nullptr) {
+            return false;
+        }
+        int parsed_level = levelFromName(std::string_view(line + 1, static_cast<std::size_t>(close - line - 1)));
+        std::size_t stamp = static_cast<std::size_t>(close - line) + 3; // "] ["
+        if (parsed_level == UnknownLevel || stamp + StampLength > size || close[1] != ' ' || close[2] != '[') {
+            return false;
+        }
+        std::int64_t seconds = secondsFor(line + stamp);
+        if (seconds < 0) {
+            return false;
+        }
+        int millis = 0;
+        std::size_t fraction = stamp + StampLength;
+        if (fraction + 4 <= size && line[fraction] == '.' && !digits(line + fraction + 1, 3, millis)) {
+            millis = 0;
+        }
+        level = parsed_level;
+        ms = seconds * 1000 + millis;
+        return true;
+    }
+
+    // Время для запросов: начало "YYYY.MM.DD HH:MM:SS.mmm", недостающая часть
+    // берётся нулевой ("2024.05.01 13" - 13:00:00.000)
+    static bool parseTime(std::string_view text, std::int64_t& ms) {
+        std::string stamp = "0000.01.01 00:00:00.000";
+        if (text.size() > stamp.size()) {
+            return false;
+        }
+        stamp.replace(0, text.size(), text);
+        LogLineParser parser;
+        std::int64_t seconds = parser.secondsFor(stamp.c_str());
+        int millis = 0;
+        if (seconds < 0 || stamp[StampLength] != '.' || !digits(stamp.c_str() + StampLength + 1, 3, millis)) {
+            return false;
+        }
+        ms = seconds * 1000 + millis;
+        return true;
+    }
+};
+
+// Запись индекса: блок строк файла журнала. Блоки идут подряд без пропусков
+struct LogIndexEntry {
+    std::uint64_t offset = 0;   // начало блока в файле
+    std::uint32_t size = 0;     // длина в байтах, вместе с переводами строк
+    std::uint32_t lines = 0;
+    std::int64_t first_ms = 0;  // наименьшее время строки в блоке
+    std::int64_t last_ms = 0;   // наибольшее
+    std::uint8_t levels = 0;    // бит на уровень; бит UnknownLevel - строки без заголовка
+    std::uint8_t reserved[7] = {};
+};
+
+// Файл журнала только для чтения, отображённый в память. Читаются лишь
+// страницы, к которым обращаются: упреждающее чтение всего файла выключено,
+// нужные диапазоны запрашиваются через prefetch()
+class MappedLogFile {
+private:
+    int fd_ = -1;
+    char* data_ = nullptr;
+    std::size_t size_ = 0;
+
+public:
+    explicit MappedLogFile(const std::string& path) {
+        fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        if (fd_ < 0 || ::fstat(fd_, &info) != 0 || info.st_size == 0) {
+            return;
+        }
+        size_ = static_cast<std::size_t>(info.st_size);
+        void* map = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd_, 0);
+        if (map == MAP_FAILED) {
+            size_ = 0;
+            return;
+        }
+        data_ = static_cast<char*>(map);
+        ::madvise(data_, size_, MADV_RANDOM);
+    }
+
+    MappedLogFile(const MappedLogFile&) = delete;
+    MappedLogFile& operator=(const MappedLogFile&) = delete;
+
+    ~MappedLogFile() {
+        if (data_ != nullptr) {
+            ::munmap(data_, size_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool good() const {
+        return fd_ >= 0;
+    }
+
+    const char* data() const {
+        return data_;
+    }
+
+    std::size_t size() const {
+        return size_;
+    }
+
+    // Просит ядро заранее прочитать диапазон, который сейчас будет просмотрен
+    void prefetch(std::uint64_t offset, std::size_t length) const {
+        if (data_ == nullptr || offset >= size_) {
+            return;
+        }
+        std::uint64_t page = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+        std::uint64_t begin = offset / page * page;
+        std::uint64_t end = offset + length < size_ ? offset + length : size_;
+        ::madvise(data_ + begin, static_cast<std::size_t>(end - begin), MADV_WILLNEED);
+    }
+
+    // Вызывает visit(line, size) для каждой строки диапазона (без '\n')
+    template<typename Visitor>
+    void forEachLine(std::uint64_t offset, std::uint64_t length, Visitor&& visit) const {
+        std::uint64_t end = offset + length < size_ ? offset + length : size_;
+        while (offset < end) {
+            const char* line = data_ + offset;
+            std::size_t rest = static_cast<std::size_t>(end - offset);
+            const char* newline = static_cast<const char*>(std::memchr(line, '\n', rest));
+            std::size_t line_size = newline != nullptr ? static_cast<std::size_t>(newline - line) : rest;
+            visit(line, line_size);
+            offset += line_size + 1;
+        }
+    }
+};
+
+// Разреженный индекс файла журнала в <файл>.idx: заголовок "LIDX0001" и
+// записи LogIndexEntry, по одной на каждые block_size байт журнала. Строится
+// на ходу (FileHandler::enableIndex передаёт сюда каждую строку) или заново
+// по готовому файлу (attach). Запись в индекс - один write на блок
+class LogIndexBuilder {
+public:
+    static constexpr char Magic[8] = {'L', 'I', 'D', 'X', '0', '0', '0', '1'};
+
+private:
+    std::string index_path_;
+    int fd_ = -1;
+    std::size_t block_size_;
+    std::uint64_t offset_ = 0; // конец учтённой части журнала
+    LogIndexEntry block_;
+    std::int64_t last_ms_ = 0; // строки без заголовка получают время предыдущей
+    LogLineParser parser_;
+
+    void emit() {
+        if (block_.size == 0) {
+            return;
+        }
+        if (fd_ >= 0) {
+            ssize_t written = ::write(fd_, &block_, sizeof(block_));
+            (void)written;
+        }
+        offset_ = block_.offset + block_.size;
+        block_ = LogIndexEntry();
+    }
+
+    bool openIndex(bool truncate) {
+        fd_ = ::open(index_path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        if (truncate) {
+            ssize_t written = ::write(fd_, Magic, sizeof(Magic));
+            (void)written;
+        }
+        return true;
+    }
+
+public:
+    explicit LogIndexBuilder(std::size_t block_size = 64 * 1024) : block_size_(block_size) {}
+
+    LogIndexBuilder(const LogIndexBuilder&) = delete;
+    LogIndexBuilder& operator=(const LogIndexBuilder&) = delete;
+
+    ~LogIndexBuilder() {
+        close();
+    }
+
+    // Читает индекс; false - файла нет или это не индекс
+    static bool read(const std::string& index_path, std::vector<LogIndexEntry>& entries) {
+        entries.clear();
+        std::FILE* file = std::fopen(index_path.c_str(), "rb");
+        if (file == nullptr) {
+            return false;
+        }
+        char magic[sizeof(Magic)];
+        bool valid = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                     std::memcmp(magic, Magic, sizeof(Magic)) == 0;
+        LogIndexEntry entry;
+        while (valid && std::fread(&entry, sizeof(entry), 1, file) == 1) {
+            entries.push_back(entry);
+        }
+        std::fclose(file);
+        return valid;
+    }
+
+    // Открывает индекс файла журнала log_path и доводит его до конца файла:
+    // существующий индекс продолжается с последнего блока, хвост журнала
+    // после него дочитывается; испорченный или чужой индекс строится заново
+    bool attach(const std::string& log_path, const std::string& index_path) {
+        close();
+        index_path_ = index_path;
+        MappedLogFile log(log_path);
+        std::vector<LogIndexEntry> entries;
+        bool usable = read(index_path, entries);
+        std::uint64_t end = 0;
+        for (const auto& entry : entries) {
+            if (entry.offset != end) {
+                usable = false; // блоки должны идти подряд
+            }
+            end = entry.offset + entry.size;
+        }
+        if (!usable || end > log.size()) {
+            entries.clear();
+            end = 0;
+            usable = false;
+        }
+        if (!openIndex(!usable)) {
+            return false;
+        }
+        offset_ = end;
+        block_ = LogIndexEntry();
+        last_ms_ = entries.empty() ? 0 : entries.back().last_ms;
+        if (log.size() > end) {
+            log.prefetch(end, log.size() - end);
+            std::uint64_t position = end;
+            log.forEachLine(end, log.size() - end, [&](const char* line, std::size_t size) {
+                position += size + 1;
+                addLine(line, size, position <= log.size());
+            });
+        }
+        return true;
+    }
+
+    // Строка журнала без перевода строки; has_newline = false - только для
+    // недописанной последней строки файла
+    void addLine(const char* data, std::size_t size, bool has_newline = true) {
+        int level = LogLineParser::UnknownLevel;
+        std::int64_t ms = last_ms_;
+        if (parser_.parse(data, size, level, ms)) {
+            last_ms_ = ms;
+        }
+        if (block_.size == 0) {
+            block_.offset = offset_;
+            block_.first_ms = ms;
+            block_.last_ms = ms;
+        }
+        block_.size += static_cast<std::uint32_t>(size + (has_newline ? 1 : 0));
+        ++block_.lines;
+        block_.first_ms = ms < block_.first_ms ? ms : block_.first_ms;
+        block_.last_ms = ms > block_.last_ms ? ms : block_.last_ms;
+        block_.levels |= static_cast<std::uint8_t>(1u << level);
+        if (block_.size >= block_size_) {
+            emit();
+        }
+    }
+
+    // Записывает неполный блок; следующие строки начнут новый
+    void finish() {
+        emit();
+    }
+
+    // Журнал переименован при ротации: индекс закрывается и переносится в
+    // rotated_index_path (пустой путь - удаляется), новый начинается с нуля
+    void rotate(const std::string& rotated_index_path) {
+        finish();
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        if (rotated_index_path.empty()) {
+            ::unlink(index_path_.c_str());
+        } else {
+            ::rename(index_path_.c_str(), rotated_index_path.c_str());
+        }
+        offset_ = 0;
+        block_ = LogIndexEntry();
+        openIndex(true);
+    }
+
+    void close() {
+        finish();
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+};
@@ -0,0 +1,1716 @@
+#pragma once
+// Логгер целиком: фильтры, форматтеры, обработчики и Logger.
+// Используется демонстрацией (main.cpp) и бенчмарками
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <string_view>
+#include <cstdint>
+#include <locale>
+#include <codecvt>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <type_traits>
+#include <initializer_list>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include "mpsc_ring.hpp"
+#include "bounded_queue.hpp"
+#include "buffered_file.hpp"
+#include "console_writer.hpp"
+#include "timestamp_engine.hpp"
+#include "regex_engine.hpp"
+#include "aho_corasick.hpp"
+#include "substring_search.hpp"
+#include "mapped_segment.hpp"
+#include "background_compressor.hpp"
+#include "socket_sender.hpp"
+#include "syslog_sender.hpp"
+#include "segment_uploader.hpp"
+#include "log_fields.hpp"
+#include "binary_log.hpp"
+#include "format_string.hpp"
+#include "rate_limiter.hpp"
+#include "burst_dedup.hpp"
+#include "crash_flush.hpp"
+#include "level_config.hpp"
+#include "logger_metrics.hpp"
+#include "log_index.hpp"
+
+enum class LogLevel {
+    DEBUG,
+    INFO,
+    WARN,
+    ERROR
+};
+
+// Вспомогательная функция для преобразования LogLevel в строку
+inline const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::WARN: return "WARN";
+        case LogLevel::ERROR: return "ERROR";
+        default: return "UNKNOWN";
+    }
+}
+
+inline std::string logLevelToString(LogLevel level) {
+    return logLevelName(level);
+}
+
+// Абстрактный класс фильтров
+class ILogFilter {
+public:
+    virtual ~ILogFilter() = default;
+    virtual bool match(LogLevel log_level, const std::string& text) = 0;
+
+    // Проверка записи вместе с полями; фильтры по тексту её не переопределяют
+    virtual bool matchRecord(LogLevel log_level, const std::string& text, const FieldBuffer& fields) {
+        return match(log_level, text);
+    }
+
+    // Уровень, ниже которого фильтр гарантированно ничего не пропускает.
+    // Logger использует его, чтобы отбрасывать записи до построения сообщения
+    virtual LogLevel minimumLevel() const {
+        return LogLevel::DEBUG;
+    }
+};
+
+
+
+// фильтрация по вхождению текста
+class SimpleLogFilter : public ILogFilter {
+private:
+    SubstringSearcher pattern_;
+public:
+    explicit SimpleLogFilter(const std::string& pattern) : pattern_(pattern) {}
+    
+    bool match(LogLevel log_level, const std::string& text) override {
+        return pattern_.contains(text);
+    }
+};
+
+// фильтрация по списку ключевых слов за один проход по тексту:
+// ANY - нужно хотя бы одно слово, ALL - нужны все
+enum class KeywordMatchMode {
+    ANY,
+    ALL
+};
+
+class KeywordLogFilter : public ILogFilter {
+private:
+    AhoCorasick automaton_;
+    KeywordMatchMode mode_;
+    // Для одного слова SIMD-поиск быстрее автомата
+    std::unique_ptr<SubstringSearcher> single_;
+public:
+    explicit KeywordLogFilter(const std::vector<std::string>& keywords,
+                              KeywordMatchMode mode = KeywordMatchMode::ANY)
+        : automaton_(keywords), mode_(mode) {
+        if (keywords.size() == 1) {
+            single_ = std::make_unique<SubstringSearcher>(keywords[0]);
+        }
+    }
+
+    bool match(LogLevel log_level, const std::string& text) override {
+        if (single_) {
+            return single_->contains(text);
+        }
+        return mode_ == KeywordMatchMode::ANY ? automaton_.containsAny(text)
+                                              : automaton_.containsAll(text);
+    }
+};
+
+// фильтрация по регулярному выражению (без возвратов, см. regex_engine.hpp);
+// при неподдерживаемом синтаксисе конструктор бросает std::invalid_argument
+class ReLogFilter : public ILogFilter {
+private:
+    CompiledRegex pattern_;
+public:
+    explicit ReLogFilter(const std::string& pattern) : pattern_(pattern) {}
+    
+    bool match(LogLevel log_level, const std::string& text) override {
+        return pattern_.search(text);
+    }
+};
+
+// фильтрация по уровню логирования. Проверяет все записи, в том числе
+// дочерних логгеров, поэтому вместе с уровнями модулей (setModuleLevel,
+// configureLevels) "net.http = DEBUG" ниже min_level не пропустит; общий
+// уровень в этом случае задают через setModuleLevel("root", ...)
+class LevelFilter : public ILogFilter {
+private:
+    LogLevel min_level_;
+public:
+    explicit LevelFilter(LogLevel min_level) : min_level_(min_level) {}
+    
+    bool match(LogLevel log_level, const std::string& text) override {
+        return static_cast<int>(log_level) >= static_cast<int>(min_level_);
+    }
+
+    LogLevel minimumLevel() const override {
+        return min_level_;
+    }
+};
+
+enum class FieldOp {
+    EQUAL,
+    NOT_EQUAL,
+    LESS,
+    LESS_EQUAL,
+    GREATER,
+    GREATER_EQUAL,
+    EXISTS
+};
+
+// фильтрация по значению поля структурированной записи, без разбора текста:
+// FieldFilter("latency_us", FieldOp::GREATER, 1000). Числа разных типов
+// сравниваются по значению; записи без поля не проходят
+class FieldFilter : public ILogFilter {
+private:
+    std::string key_;
+    FieldOp op_;
+    std::string string_value_; // владеет строкой, на которую ссылается comparand_
+    LogField comparand_;
+
+public:
+    template<typename T>
+    FieldFilter(const std::string& key, FieldOp op, const T& value)
+        : key_(key), op_(op), comparand_(key_, value) {
+        if (comparand_.type == FieldType::STRING) {
+            string_value_ = std::string(comparand_.string_value);
+            comparand_.string_value = string_value_;
+        }
+    }
+
+    explicit FieldFilter(const std::string& key) : key_(key), op_(FieldOp::EXISTS) {}
+
+    FieldFilter(const FieldFilter&) = delete;
+    FieldFilter& operator=(const FieldFilter&) = delete;
+
+    bool match(LogLevel log_level, const std::string& text) override {
+        return false; // запись без полей
+    }
+
+    bool matchRecord(LogLevel log_level, const std::string& text, const FieldBuffer& fields) override {
+        LogField field;
+        if (!fields.find(key_, field)) {
+            return false;
+        }
+        if (op_ == FieldOp::EXISTS) {
+            return true;
+        }
+        int order = field.compare(comparand_);
+        if (order == 2) {
+            return op_ == FieldOp::NOT_EQUAL; // несравнимые типы
+        }
+        switch (op_) {
+            case FieldOp::EQUAL: return order == 0;
+            case FieldOp::NOT_EQUAL: return order != 0;
+            case FieldOp::LESS: return order < 0;
+            case FieldOp::LESS_EQUAL: return order <= 0;
+            case FieldOp::GREATER: return order > 0;
+            case FieldOp::GREATER_EQUAL: return order >= 0;
+            default: return true;
+        }
+    }
+};
+
+// ограничение потока одинаковых записей: корзина токенов на шаблон сообщения
+// (текст с заменёнными числами, см. KeyedRateLimiter::templateKey, плюс
+// уровень) и, по желанию, выборка 1 из N всех записей. Всё без блокировок,
+// поэтому при "шторме" из цикла ошибок
+// фильтр стоит десятки наносекунд на запись, а в обработчики попадает не
+// больше rate_per_second записей каждого шаблона.
+// Число отброшенных записей раз в report_interval передаётся в reporter
+// (по умолчанию - строка в std::cerr). reporter вызывается из потока,
+// применяющего фильтры, и не должен писать в тот же Logger.
+// Фильтр стоит добавлять последним, чтобы токены тратили только записи,
+// прошедшие остальные фильтры
+class RateLimitFilter : public ILogFilter {
+public:
+    using Reporter = std::function<void(std::uint64_t suppressed)>;
+
+private:
+    KeyedRateLimiter limiter_;
+    std::uint32_t sample_every_;
+    std::int64_t report_interval_ns_;
+    Reporter reporter_;
+    std::chrono::steady_clock::time_point epoch_;
+    std::atomic<std::uint64_t> suppressed_{0};   // всего
+    std::atomic<std::uint64_t> reported_{0};     // из них уже отчитано
+    std::atomic<std::int64_t> next_report_ns_;
+
+    static bool sampled(std::uint32_t every) {
+        // xorshift32 на поток: без общего состояния между потоками
+        static thread_local std::uint32_t state =
+            0x9E3779B9u ^ static_cast<std::uint32_t>(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state % every == 0;
+    }
+
+    void report(std::int64_t now_ns) {
+        std::int64_t next = next_report_ns_.load(std::memory_order_relaxed);
+        if (now_ns < next) {
+            return;
+        }
+        // Отчёт пишет только поток, сдвинувший срок следующего
+        if (!next_report_ns_.compare_exchange_strong(next, now_ns + report_interval_ns_,
+                                                      std::memory_order_relaxed)) {
+            return;
+        }
+        flushReport();
+    }
+
+    void flushReport() {
+        std::uint64_t total = suppressed_.load(std::memory_order_relaxed);
+        std::uint64_t previous = reported_.exchange(total, std::memory_order_relaxed);
+        if (total > previous && reporter_) {
+            reporter_(total - previous);
+        }
+    }
+
+public:
+    explicit RateLimitFilter(double rate_per_second, std::size_t burst = 10, std::uint32_t sample_every = 1,
+                             std::chrono::milliseconds report_interval = std::chrono::seconds(10),
+                             Reporter reporter = nullptr)
+        : limiter_(rate_per_second, burst),
+          sample_every_(sample_every > 0 ? sample_every : 1),
+          report_interval_ns_(std::chrono::duration_cast<std::chrono::nanoseconds>(report_interval).count()),
+          reporter_(std::move(reporter)),
+          epoch_(std::chrono::steady_clock::now()),
+          next_report_ns_(report_interval_ns_) {
+        if (!reporter_) {
+            reporter_ = [](std::uint64_t suppressed) {
+                std::cerr << "[RATE LIMIT] suppressed " << suppressed << " records" << std::endl;
+            };
+        }
+    }
+
+    ~RateLimitFilter() override {
+        flushReport();
+    }
+
+    bool match(LogLevel log_level, const std::string& text) override {
+        std::int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch_).count();
+        bool pass = (sample_every_ == 1 || sampled(sample_every_)) &&
+                    limiter_.tryAcquire(KeyedRateLimiter::templateKey(text, static_cast<std::uint64_t>(log_level)),
+                                        now_ns);
+        if (!pass) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        report(now_ns);
+        return pass;
+    }
+
+    std::uint64_t suppressed() const {
+        return suppressed_.load(std::memory_order_relaxed);
+    }
+};
+
+// Абстрактный класс обработчиков
+class ILogHandler {
+public:
+    virtual ~ILogHandler() = default;
+    virtual void handle(LogLevel log_level, const std::string& text) = 0;
+    // Сброс накопленных данных; вызывается из того же потока, что и handle
+    virtual void flush() {}
+
+    // Аварийный путь из обработчика сигнала (Logger::enableCrashFlush): только
+    // write(2), без выделения памяти; блокировку можно взять лишь через
+    // CrashFlush::waitUntil и не отпускать. crashFlush сбрасывает накопленный
+    // буфер, crashRecord дописывает запись, не дошедшую до handle
+    virtual void crashFlush() noexcept {}
+    virtual void crashRecord(LogLevel, const char*, std::size_t) noexcept {}
+
+    // Для метрик (Logger::metricsSnapshot): сколько записей потеряно
+    // и сколько байт ушло в приёмник. Вызываются из любого потока
+    virtual std::size_t recordsDropped() const {
+        return 0;
+    }
+    virtual std::size_t bytesWritten() const {
+        return 0;
+    }
+    // Неудачные записи в приёмник (ENOSPC, EIO и т.п.)
+    virtual std::size_t writeErrors() const {
+        return 0;
+    }
+
+    // Запись с полями. По умолчанию поля дописываются к тексту как key=value;
+    // обработчики, которым нужен другой вид (JSON), переопределяют метод
+    virtual void handleRecord(LogLevel log_level, const std::string& text, const FieldBuffer& fields) {
+        if (fields.empty()) {
+            handle(log_level, text);
+            return;
+        }
+        static thread_local std::string rendered;
+        rendered.assign(text);
+        fields.appendText(rendered);
+        handle(log_level, rendered);
+    }
+};
+
+// Представление полей записи в обработчике
+enum class FieldFormat {
+    TEXT, // текст key=value
+    JSON  // одна строка JSON на запись
+};
+
+// Абстрактный класс форматтеров
+class ILogFormatter {
+public:
+    virtual ~ILogFormatter() = default;
+    virtual std::string format(LogLevel log_level, const std::string& text) = 0;
+
+    // Дописывает результат в out, не создавая временных строк.
+    // timestamp_ns - момент вызова log() или 0, если он не зафиксирован.
+    // Реализация по умолчанию нужна для форматтеров, написанных под format()
+    virtual void formatTo(LogLevel log_level, std::int64_t timestamp_ns,
+                          std::string_view text, std::string& out) {
+        out += format(log_level, std::string(text));
+    }
+
+    // Часы, по которым форматтер ставит метки, или nullptr. Logger берёт их
+    // для времени записей, зафиксированного в log() (асинхронный режим)
+    virtual const TimestampEngine* clock() const {
+        return nullptr;
+    }
+};
+
+// Реализация форматтера с временной меткой
+class TimestampFormatter : public ILogFormatter {
+private:
+    TimestampEngine engine_;
+public:
+    explicit TimestampFormatter(TimestampPrecision precision = TimestampPrecision::MILLI,
+                                ClockSource clock = ClockSource::SYSTEM)
+        : engine_(precision, clock) {}
+
+    std::string format(LogLevel log_level, const std::string& text) override {
+        std::string result;
+        formatTo(log_level, 0, text, result);
+        return result;
+    }
+
+    void formatTo(LogLevel log_level, std::int64_t timestamp_ns,
+                  std::string_view text, std::string& out) override {
+        char stamp[TimestampEngine::MaxLength];
+        std::size_t stamp_length = timestamp_ns != 0
+            ? engine_.render(timestamp_ns, stamp)
+            : engine_.renderNow(stamp);
+
+        out += '[';
+        out += logLevelName(log_level);
+        out += "] [";
+        out.append(stamp, stamp_length);
+        out += "] ";
+        out += text;
+    }
+
+    const TimestampEngine* clock() const override {
+        return &engine_;
+    }
+};
+
+
+// вывод в консоль
+class ConsoleHandler : public ILogHandler {
+private:
+    ConsoleWriter writer_;
+
+    static std::string_view getColorCode(LogLevel level) {
+        switch (level) {
+            case LogLevel::DEBUG: return "\033[36m"; // Голубой
+            case LogLevel::INFO: return "\033[32m";  // Зеленый
+            case LogLevel::WARN: return "\033[33m";  // Желтый
+            case LogLevel::ERROR: return "\033[31m"; // Красный
+            default: return "\033[0m";               // Сброс
+        }
+    }
+    
+public:
+    // Строки уходят в stdout одним write раз в flush_interval (см. console_writer.hpp),
+    // цвета - только если stdout - терминал
+    explicit ConsoleHandler(std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100),
+                            std::size_t buffer_size = 64 * 1024)
+        : writer_(STDOUT_FILENO, flush_interval, buffer_size) {}
+
+    void handle(LogLevel log_level, const std::string& text) override {
+        writer_.append(getColorCode(log_level), text.data(), text.size());
+    }
+
+    void flush() override {
+        writer_.flush();
+    }
+
+    void crashFlush() noexcept override {
+        writer_.crashFlush();
+    }
+
+    void crashRecord(LogLevel log_level, const char* text, std::size_t size) noexcept override {
+        CrashWriter out(writer_.descriptor());
+        out.put('[');
+        out.put(logLevelName(log_level));
+        out.put("] [crash] ");
+        out.put(text, size);
+        out.put('\n');
+    }
+
+    std::size_t bytesWritten() const override {
+        return writer_.bytesWritten();
+    }
+};
+
+// запись в файл: строки копятся в буфере и пишутся крупными блоками,
+// durable = true включает групповой fsync раз в flush_interval
+class FileHandler : public ILogHandler {
+private:
+    std::string filename_;
+    std::shared_ptr<BackgroundCompressor> compressor_;
+    std::unique_ptr<LogIndexBuilder> index_; // объявлен до file_: file_ обращается к нему
+    BufferedFileWriter file_;
+    FieldFormat field_format_ = FieldFormat::TEXT;
+public:
+    explicit FileHandler(const std::string& filename,
+                         std::size_t buffer_size = 64 * 1024,
+                         std::chrono::milliseconds flush_interval = std::chrono::milliseconds(200),
+                         bool durable = false)
+        : filename_(filename), file_(filename, buffer_size, flush_interval, durable) {}
+    
+    void handle(LogLevel log_level, const std::string& text) override {
+        if (field_format_ == FieldFormat::JSON) {
+            handleRecord(log_level, text, FieldBuffer());
+            return;
+        }
+        if (file_.isOpen()) {
+            file_.appendLine(text.data(), text.size());
+        }
+    }
+
+    void handleRecord(LogLevel log_level, const std::string& text, const FieldBuffer& fields) override {
+        if (field_format_ == FieldFormat::TEXT) {
+            ILogHandler::handleRecord(log_level, text, fields);
+            return;
+        }
+        if (!file_.isOpen()) {
+            return;
+        }
+        // В синхронном режиме обработчик вызывают из многих потоков,
+        // поэтому строка собирается в буфере своего потока
+        static thread_local std::string line;
+        line.assign("{\"level\":\"");
+        line += logLevelName(log_level);
+        line += "\",\"message\":";
+        FieldBuffer::appendJsonString(line, text);
+        if (!fields.empty()) {
+            line += ',';
+            fields.appendJson(line);
+        }
+        line += '}';
+        file_.appendLine(line.data(), line.size());
+    }
+
+    void flush() override {
+        if (file_.isOpen()) {
+            file_.sync();
+        }
+    }
+
+    void crashFlush() noexcept override {
+        file_.crashFlush();
+    }
+
+    // Строки, не попавшие в файл из-за ошибок записи
+    std::size_t recordsDropped() const override {
+        return file_.linesLost();
+    }
+
+    std::size_t bytesWritten() const override {
+        return file_.bytesWritten();
+    }
+
+    std::size_t writeErrors() const override {
+        return file_.writeErrors();
+    }
+
+    // errno последней неудачной записи, 0 - ошибок не было
+    int lastWriteError() const {
+        return file_.lastError();
+    }
+
+    // Запись без форматтеров и полей, с пометкой crash
+    void crashRecord(LogLevel log_level, const char* text, std::size_t size) noexcept override {
+        if (!file_.isOpen()) {
+            return;
+        }
+        CrashWriter out(file_.descriptor());
+        if (field_format_ == FieldFormat::JSON) {
+            out.put("{\"level\":\"");
+            out.put(logLevelName(log_level));
+            out.put("\",\"message\":");
+            out.putJsonString(text, size);
+            out.put(",\"crash\":true}\n");
+            return;
+        }
+        out.put('[');
+        out.put(logLevelName(log_level));
+        out.put("] [crash] ");
+        out.put(text, size);
+        out.put('\n');
+    }
+
+    // JSON: каждая запись - объект {"level","message", поля...}.
+    // Вызывать до начала логирования
+    void setFieldFormat(FieldFormat format) {
+        field_format_ = format;
+    }
+
+    // Ротация по размеру; если задан compressor, закрытые файлы сжимаются в фоне
+    // (и те, что остались несжатыми с прошлого запуска).
+    // Вызывать до начала логирования
+    void enableRotation(std::size_t max_file_size,
+                        std::shared_ptr<BackgroundCompressor> compressor = nullptr) {
+        compressor_ = std::move(compressor);
+        if (compressor_) {
+            compressor_->submitRotated(filename_);
+        }
+        file_.enableRotation(max_file_size, [this](const std::string& rotated) {
+            if (index_) {
+                // Смещения в индексе относятся к несжатому файлу
+                index_->rotate(compressor_ ? std::string() : rotated + ".idx");
+            }
+            if (compressor_) {
+                compressor_->submit(rotated);
+            }
+        });
+    }
+
+    // Разреженный индекс <файл>.idx: смещения блоков по block_size байт с
+    // временем и уровнями строк (см. log_index.hpp, запросы - tools/log_query).
+    // Существующий индекс дополняется до конца файла. Вызывать до начала логирования
+    void enableIndex(std::size_t block_size = 64 * 1024) {
+        index_ = std::make_unique<LogIndexBuilder>(block_size);
+        if (!index_->attach(filename_, filename_ + ".idx")) {
+            index_.reset();
+            return;
+        }
+        LogIndexBuilder* index = index_.get();
+        file_.setLineObserver([index](const char* data, std::size_t size) {
+            index->addLine(data, size);
+        });
+    }
+};
+
+// запись в отображённые в память сегменты фиксированного размера с ротацией
+// (см. mapped_segment.hpp); хранится не более max_segments файлов
+class MappedFileHandler : public ILogHandler {
+private:
+    MappedSegmentWriter writer_;
+public:
+    explicit MappedFileHandler(const std::string& directory,
+                               const std::string& base_name = "app",
+                               std::size_t segment_size = 64 * 1024 * 1024,
+                               std::size_t max_segments = 8)
+        : writer_(directory, base_name, segment_size, max_segments) {}
+
+    void handle(LogLevel log_level, const std::string& text) override {
+        std::int64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        writer_.appendLine(timestamp_ns, text.data(), text.size());
+    }
+
+    void flush() override {
+        writer_.sync();
+    }
+};
+
+// отправка по сети пачками (см. socket_sender.hpp); для проверки
+// на одной машине есть приёмник tools/log_receiver
+class SocketHandler : public ILogHandler {
+private:
+    BatchedSocketSender sender_;
+public:
+    SocketHandler(const std::string& address, int port,
+                  SocketTransport transport = SocketTransport::UDP,
+                  std::size_t batch_bytes = 16 * 1024,
+                  std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100))
+        : sender_(address, port, transport, batch_bytes, flush_interval) {}
+    
+    void handle(LogLevel log_level, const std::string& text) override {
+        sender_.send(text.data(), text.size());
+    }
+
+    void flush() override {
+        sender_.flush();
+    }
+
+    std::size_t recordsDropped() const override {
+        return sender_.recordsDropped();
+    }
+
+    std::size_t recordsSent() const {
+        return sender_.recordsSent();
+    }
+
+    std::size_t recordsTruncated() const {
+        return sender_.recordsTruncated();
+    }
+
+    std::size_t bytesWritten() const override {
+        return sender_.bytesSent();
+    }
+};
+
+// запись в системный журнал кадрами RFC 5424 (см. syslog_sender.hpp)
+class SyslogHandler : public ILogHandler {
+private:
+    SyslogSender sender_;
+
+    static SyslogSeverity toSeverity(LogLevel level) {
+        switch (level) {
+            case LogLevel::DEBUG: return SyslogSeverity::DEBUG;
+            case LogLevel::INFO: return SyslogSeverity::INFORMATIONAL;
+            case LogLevel::WARN: return SyslogSeverity::WARNING;
+            case LogLevel::ERROR: return SyslogSeverity::ERROR;
+            default: return SyslogSeverity::NOTICE;
+        }
+    }
+
+public:
+    explicit SyslogHandler(const std::string& socket_path = "/dev/log",
+                           const std::string& app_name = "logging_system",
+                           int facility = 1)
+        : sender_(socket_path, app_name, facility) {}
+
+    void handle(LogLevel log_level, const std::string& text) override {
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        sender_.send(toSeverity(log_level), now, text.data(), text.size());
+    }
+
+    void flush() override {
+        sender_.flush();
+    }
+
+    std::size_t recordsDropped() const override {
+        return sender_.recordsDropped();
+    }
+};
+
+// выгрузка на FTP сервер: записи копятся в локальном каталоге spool_dir,
+// закрытые сегменты (по размеру или раз в seal_interval) выгружаются
+// в фоне в server_ + path_ (см. segment_uploader.hpp).
+// server_ вида "file://<каталог>" складывает сегменты в каталог - для проверки без сервера
+class FtpHandler : public ILogHandler {
+private:
+    std::string server_;
+    std::string path_;
+    BufferedFileWriter spool_;
+    SegmentUploader uploader_; // объявлен после spool_: останавливается первым
+
+    // Сегменты, закрытые в прошлых запусках и не успевшие уйти на сервер
+    static std::vector<std::string> findSealed(const std::string& spool_dir, const std::string& base_name) {
+        std::vector<std::string> sealed;
+        std::error_code error;
+        for (const auto& entry : std::filesystem::directory_iterator(spool_dir, error)) {
+            std::string name = entry.path().filename().string();
+            if (name.size() > base_name.size() + 1 && name.compare(0, base_name.size() + 1, base_name + ".") == 0 &&
+                std::isdigit(static_cast<unsigned char>(name[base_name.size() + 1]))) {
+                sealed.push_back(entry.path().string());
+            }
+        }
+        std::sort(sealed.begin(), sealed.end());
+        return sealed;
+    }
+
+    static std::string prepareSpool(const std::string& spool_dir) {
+        std::error_code error;
+        std::filesystem::create_directories(spool_dir, error);
+        return (std::filesystem::path(spool_dir) / "ftp_spool.log").string();
+    }
+
+public:
+    FtpHandler(const std::string& server, const std::string& path = "",
+               const std::string& spool_dir = "ftp_spool",
+               std::size_t segment_size = 8 * 1024 * 1024,
+               std::chrono::milliseconds seal_interval = std::chrono::seconds(60),
+               const std::string& user = "anonymous", const std::string& password = "logger@",
+               std::size_t max_spool_segments = 64)
+        : server_(server), path_(path),
+          spool_(prepareSpool(spool_dir)),
+          uploader_(server, path, user, password, seal_interval, [this] { spool_.rotate(); },
+                    max_spool_segments) {
+        for (const auto& sealed : findSealed(spool_dir, "ftp_spool.log")) {
+            uploader_.submit(sealed);
+        }
+        SegmentUploader* uploader = &uploader_;
+        spool_.enableRotation(segment_size, [uploader](const std::string& sealed) {
+            uploader->submit(sealed);
+        });
+        // Незакрытый сегмент, оставшийся после аварии, тоже уходит на сервер
+        spool_.rotate();
+    }
+
+    ~FtpHandler() {
+        spool_.rotate();
+    }
+
+    void handle(LogLevel log_level, const std::string& text) override {
+        if (spool_.isOpen()) {
+            spool_.appendLine(text.data(), text.size());
+        }
+    }
+
+    void flush() override {
+        if (spool_.isOpen()) {
+            spool_.sync();
+        }
+    }
+
+    std::size_t uploadedSegments() const {
+        return uploader_.uploadedCount();
+    }
+
+    // Сегменты, удалённые из переполненного каталога без выгрузки
+    std::size_t discardedSegments() const {
+        return uploader_.discardedCount();
+    }
+
+    std::size_t recordsDropped() const override {
+        return spool_.linesLost();
+    }
+
+    std::size_t bytesWritten() const override {
+        return spool_.bytesWritten();
+    }
+
+    std::size_t writeErrors() const override {
+        return spool_.writeErrors();
+    }
+};
+
+// Запись, передаваемая из log() в фоновый поток
+struct LogRecord {
+    LogLevel level = LogLevel::INFO;
+    std::int64_t timestamp_ns = 0;
+    std::string text; // ёмкость строки переиспользуется ячейкой очереди
+    FieldBuffer fields;
+};
+
+// Выполняет вложенный обработчик в отдельном потоке со своей очередью,
+// чтобы медленный приёмник не задерживал остальные
+class AsyncHandler : public ILogHandler {
+private:
+    struct Item {
+        LogLevel level = LogLevel::INFO;
+        std::string text;
+        bool flush = false;
+        FieldBuffer fields;
+    };
+
+    std::unique_ptr<ILogHandler> inner_;
+    BoundedQueue<Item> queue_;
+    std::thread worker_;
+
+    std::mutex flush_mutex_;
+    std::condition_variable flush_done_cv_;
+    std::size_t flush_requested_ = 0;
+    std::size_t flush_done_ = 0;
+
+    void workerLoop() {
+        Item item;
+        while (queue_.pop(item)) {
+            if (item.flush) {
+                inner_->flush();
+                {
+                    std::lock_guard<std::mutex> lock(flush_mutex_);
+                    ++flush_done_;
+                }
+                flush_done_cv_.notify_all();
+            } else {
+                inner_->handleRecord(item.level, item.text, item.fields);
+            }
+        }
+        inner_->flush();
+    }
+
+public:
+    explicit AsyncHandler(std::unique_ptr<ILogHandler> inner,
+                          std::size_t capacity = 1024,
+                          OverflowPolicy policy = OverflowPolicy::BLOCK)
+        : inner_(std::move(inner)), queue_(capacity, policy, [](const Item& item) { return item.flush; }) {
+        worker_ = std::thread(&AsyncHandler::workerLoop, this);
+    }
+
+    ~AsyncHandler() {
+        queue_.close();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    void handle(LogLevel log_level, const std::string& text) override {
+        queue_.push(Item{log_level, text, false, FieldBuffer()});
+    }
+
+    void handleRecord(LogLevel log_level, const std::string& text, const FieldBuffer& fields) override {
+        queue_.push(Item{log_level, text, false, fields});
+    }
+
+    // Записи в собственной очереди при аварии теряются: обходить её без
+    // блокировки нельзя. Сбрасывается только буфер вложенного обработчика
+    void crashFlush() noexcept override {
+        inner_->crashFlush();
+    }
+
+    void crashRecord(LogLevel log_level, const char* text, std::size_t size) noexcept override {
+        inner_->crashRecord(log_level, text, size);
+    }
+
+    // Ждёт, пока вложенный обработчик получит все записи, поставленные до вызова
+    void flush() override {
+        std::size_t ticket;
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex_);
+            ticket = ++flush_requested_;
+        }
+        // Маркер сброса не должен теряться при политиках DROP_*: он ставится
+        // с ожиданием места, а DROP_OLDEST его не вытесняет (pinned)
+        if (!queue_.push(Item{LogLevel::INFO, std::string(), true, FieldBuffer()}, OverflowPolicy::BLOCK)) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(flush_mutex_);
+        flush_done_cv_.wait(lock, [this, ticket] { return flush_done_ >= ticket; });
+    }
+
+    std::size_t dropped() const {
+        return queue_.dropped();
+    }
+
+    std::size_t recordsDropped() const override {
+        return queue_.dropped() + inner_->recordsDropped();
+    }
+
+    std::size_t bytesWritten() const override {
+        return inner_->bytesWritten();
+    }
+
+    std::size_t writeErrors() const override {
+        return inner_->writeErrors();
+    }
+
+    std::size_t queued() const {
+        return queue_.size();
+    }
+};
+
+class Logger;
+
+// Именованный дочерний логгер ("net.http", "db.pool"): пишет в тот же Logger,
+// добавляя к тексту "[имя] ", но со своим уровнем. Уровень наследуется от
+// предков по точкам и меняется на ходу (Logger::configureLevels,
+// Logger::setModuleLevel); проверка уровня - одно атомарное чтение.
+// Создаётся через Logger::getLogger и живёт столько же, сколько Logger
+class ModuleLogger {
+private:
+    Logger* parent_;
+    std::string name_;
+    std::string prefix_;
+    std::atomic<int> min_level_{static_cast<int>(LogLevel::DEBUG)};
+
+    friend class Logger;
+
+    void write(LogLevel log_level, const std::string& text, std::initializer_list<LogField> fields);
+
+public:
+    ModuleLogger(Logger* parent, const std::string& name)
+        : parent_(parent), name_(name), prefix_("[" + name + "] ") {}
+
+    ModuleLogger(const ModuleLogger&) = delete;
+    ModuleLogger& operator=(const ModuleLogger&) = delete;
+
+    const std::string& name() const {
+        return name_;
+    }
+
+    bool isEnabled(LogLevel log_level) const {
+        return static_cast<int>(log_level) >= min_level_.load(std::memory_order_relaxed);
+    }
+
+    // Дочерний логгер: child("client") у "net.http" - это "net.http.client"
+    ModuleLogger& child(const std::string& suffix);
+
+    void log(LogLevel log_level, const std::string& text) {
+        if (isEnabled(log_level)) {
+            write(log_level, text, {});
+        }
+    }
+
+    void log(LogLevel log_level, const std::string& text, std::initializer_list<LogField> fields) {
+        if (isEnabled(log_level)) {
+            write(log_level, text, fields);
+        }
+    }
+
+    // Для макросов LOGF_* (см. Logger::logFormat)
+    template<typename FormatSource, typename... Args>
+    void logFormat(FormatSource format_source, LogLevel log_level, const Args&... args) {
+        static_assert(FormatString::check<Args...>(format_source));
+        constexpr std::string_view format = format_source();
+        static constexpr auto parsed = FormatString::parse<FormatString::opCount(format)>(format);
+        if (!isEnabled(log_level)) {
+            return;
+        }
+        std::string text;
+        text.reserve(format.size() + 16 * sizeof...(Args));
+        FormatString::render(text, format, parsed, args...);
+        write(log_level, text, {});
+    }
+
+    void log_debug(const std::string& text) {
+        log(LogLevel::DEBUG, text);
+    }
+
+    void log_info(const std::string& text) {
+        log(LogLevel::INFO, text);
+    }
+
+    void log_warn(const std::string& text) {
+        log(LogLevel::WARN, text);
+    }
+
+    void log_error(const std::string& text) {
+        log(LogLevel::ERROR, text);
+    }
+};
+
+// Основной класс
+class Logger : private CrashFlushTarget {
+private:
+    std::vector<std::unique_ptr<ILogFilter>> filters_;
+    std::vector<std::unique_ptr<ILogFormatter>> formatters_;
+    std::vector<std::unique_ptr<ILogHandler>> handlers_;
+
+    // Асинхронный режим: log() только кладёт запись в очередь,
+    // фильтры, форматтеры и обработчики выполняются в worker_
+    std::unique_ptr<MpscRing<LogRecord>> queue_;
+    std::thread worker_;
+    std::atomic<bool> running_{false};
+    std::atomic<std::size_t> processed_{0};
+    std::atomic<std::size_t> flush_requested_{0};
+    std::atomic<std::size_t> flush_done_{0};
+
+    // Минимальный уровень, который может пройти фильтры; проверяется
+    // до построения сообщения в ленивых методах и макросах LOG_*
+    std::atomic<int> min_level_{static_cast<int>(LogLevel::DEBUG)};
+
+    // Часы для времени записей (см. nowNs); принадлежат форматтеру из formatters_
+    const TimestampEngine* clock_ = nullptr;
+
+    // Двоичный журнал для LOG_DEFERRED; без него записи форматируются сразу
+    std::unique_ptr<BinaryLogWriter> binary_log_;
+
+    // Сворачивание повторов между фильтрами и форматтерами (enableDeduplication)
+    std::unique_ptr<BurstDeduplicator> dedup_;
+
+    // Дочерние логгеры по имени и их уровни. levels_ объявлен после modules_,
+    // чтобы наблюдатель за конфигурацией остановился раньше, чем они удалятся
+    std::mutex modules_mutex_;
+    std::unordered_map<std::string, std::unique_ptr<ModuleLogger>> modules_;
+    std::unique_ptr<LevelRegistry> levels_;
+
+    bool crash_flush_ = false;
+    // Аварийный сброс останавливает фоновый поток между записями
+    std::atomic<bool> crash_stop_{false};
+    std::atomic<bool> worker_parked_{false};
+
+    // Метрики (enableMetrics): счётчики по фильтрам в порядке filters_,
+    // задержки по обработчикам в порядке handlers_. Пока не включены,
+    // горячий путь проверяет только указатель
+    struct Metrics {
+        std::atomic<std::uint64_t> records{0};
+        std::vector<std::unique_ptr<FilterMetrics>> filters;
+        std::vector<std::unique_ptr<HandlerMetrics>> handlers;
+    };
+    std::unique_ptr<Metrics> metrics_;
+    mutable std::mutex queue_mutex_; // queue_ в startAsync/stopAsync против metricsSnapshot
+    std::unique_ptr<MetricsExporter> metrics_exporter_;
+
+    friend class ModuleLogger;
+
+    // Пара буферов форматирования на поток: форматтеры по очереди пишут
+    // из одного в другой, память остаётся выделенной между вызовами
+    struct FormatScratch {
+        std::string first;
+        std::string second;
+        bool busy = false;
+    };
+
+    void dispatch(LogLevel log_level, std::int64_t timestamp_ns, const std::string& text,
+                  const FieldBuffer& fields) {
+        Metrics* metrics = metrics_.get();
+        if (metrics) {
+            metrics->records.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // В синхронном режиме нет фонового потока, который выводит сводку по
+        // истёкшей серии: это делает любая следующая запись, даже отброшенная
+        // фильтрами
+        if (dedup_ && !queue_) {
+            releaseBursts(true);
+        }
+
+        // Применяем фильтры
+        for (std::size_t i = 0; i < filters_.size(); ++i) {
+            bool pass = filters_[i]->matchRecord(log_level, text, fields);
+            if (metrics) {
+                FilterMetrics& counters = *metrics->filters[i];
+                (pass ? counters.accepted : counters.filtered).fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!pass) {
+                return; // Сообщение не прошло фильтр
+            }
+        }
+
+        if (dedup_) {
+            if (timestamp_ns == 0) {
+                timestamp_ns = nowNs();
+            }
+            BurstSummary summary;
+            bool has_summary = false;
+            bool pass = dedup_->offer(static_cast<int>(log_level), text, fields, timestamp_ns,
+                                      summary, has_summary);
+            if (has_summary) {
+                emitSummary(summary);
+            }
+            if (!pass) {
+                return; // повтор учтён в сводке
+            }
+        }
+        emit(log_level, timestamp_ns, text, fields);
+    }
+
+    // Форматтеры и обработчики для прошедшей фильтры записи
+    void emit(LogLevel log_level, std::int64_t timestamp_ns, const std::string& text,
+              const FieldBuffer& fields) {
+        static thread_local FormatScratch thread_scratch;
+        FormatScratch nested_scratch; // если обработчик сам пишет в лог
+        FormatScratch& scratch = thread_scratch.busy ? nested_scratch : thread_scratch;
+        scratch.busy = true;
+        
+        // Применяем форматтеры
+        const std::string* formatted_text = &text;
+        for (const auto& formatter : formatters_) {
+            std::string& out = formatted_text == &scratch.first ? scratch.second : scratch.first;
+            out.clear();
+            formatter->formatTo(log_level, timestamp_ns, *formatted_text, out);
+            formatted_text = &out;
+        }
+        
+        // Передаем обработчикам
+        if (Metrics* metrics = metrics_.get()) {
+            for (std::size_t i = 0; i < handlers_.size(); ++i) {
+                auto start = std::chrono::steady_clock::now();
+                handlers_[i]->handleRecord(log_level, *formatted_text, fields);
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                metrics->handlers[i]->latency.record(static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+            }
+        } else {
+            for (const auto& handler : handlers_) {
+                handler->handleRecord(log_level, *formatted_text, fields);
+            }
+        }
+        scratch.busy = false;
+    }
+
+    // Часы первого форматтера, у которого они есть (ClockSource::TSC в
+    // TimestampFormatter действует и в асинхронном режиме), иначе system_clock
+    std::int64_t nowNs() const {
+        if (clock_ != nullptr) {
+            return clock_->now();
+        }
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // "last message repeated N times" с числом повторов и временем первого
+    // и последнего в полях; время самой записи - время последнего повтора
+    void emitSummary(const BurstSummary& summary) {
+        std::string text = "last message repeated " + std::to_string(summary.repeats) + " times";
+        if (!summary.last_text.empty()) {
+            text += ", last: ";
+            text += summary.last_text;
+        }
+        FieldBuffer fields;
+        fields.add(LogField("repeats", summary.repeats));
+        fields.add(LogField("first_ts_ns", summary.first_ns));
+        fields.add(LogField("last_ts_ns", summary.last_ns));
+        emit(static_cast<LogLevel>(summary.level), summary.last_ns, text, fields);
+    }
+
+    // Сводки по сериям: все накопленные (при сбросе) или только с истёкшим окном
+    void releaseBursts(bool expired_only) {
+        if (!dedup_) {
+            return;
+        }
+        BurstSummary summary;
+        bool has_summary = expired_only ? dedup_->expire(nowNs(), summary) : dedup_->takePending(summary);
+        if (has_summary) {
+            emitSummary(summary);
+        }
+    }
+
+    // Реестр уровней создаётся при первом обращении; корневой логгер в нём - ""
+    LevelRegistry& levelsLocked() {
+        if (!levels_) {
+            levels_ = std::make_unique<LevelRegistry>(min_level_.load(std::memory_order_relaxed));
+            levels_->attach("", &min_level_);
+        }
+        return *levels_;
+    }
+
+    // Из обработчика сигнала: фоновый поток останавливается после текущей
+    // записи (если упал не он сам и он не завис в обработчике дольше 200 мс),
+    // затем сбрасываются буферы обработчиков (в них более ранние записи)
+    // и пишутся записи, которые поток ещё не забрал из очереди. Они уже
+    // прошли проверку уровня, но не фильтры и форматтеры
+    void crashFlush() noexcept override {
+        if (queue_ && worker_.get_id() != std::this_thread::get_id()) {
+            crash_stop_.store(true, std::memory_order_release);
+            CrashFlush::waitUntil([this] { return worker_parked_.load(std::memory_order_acquire); }, 200);
+        }
+        for (const auto& handler : handlers_) {
+            handler->crashFlush();
+        }
+        if (binary_log_) {
+            binary_log_->crashFlush();
+        }
+        if (queue_) {
+            queue_->forEachPending([this](const LogRecord& record) {
+                for (const auto& handler : handlers_) {
+                    handler->crashRecord(record.level, record.text.data(), record.text.size());
+                }
+            });
+        }
+    }
+
+    void flushHandlers() {
+        releaseBursts(false);
+        for (const auto& handler : handlers_) {
+            handler->flush();
+        }
+        if (binary_log_) {
+            binary_log_->flush();
+        }
+    }
+
+    void logRecord(LogLevel log_level, const std::string& text, std::initializer_list<LogField> fields) {
+        if (!isEnabled(log_level)) {
+            return;
+        }
+        submit(log_level, text, fields);
+    }
+
+    // Запись, уровень которой уже проверен (своим или дочерним логгером)
+    void submit(LogLevel log_level, const std::string& text, std::initializer_list<LogField> fields) {
+        if (!queue_) {
+            FieldBuffer encoded;
+            for (const auto& field : fields) {
+                encoded.add(field);
+            }
+            dispatch(log_level, 0, text, encoded);
+            return;
+        }
+
+        // Время фиксируем здесь: форматтер выполнится позже в другом потоке
+        std::int64_t timestamp_ns = nowNs();
+        auto fill = [&](LogRecord& record) {
+            record.level = log_level;
+            record.timestamp_ns = timestamp_ns;
+            record.text.assign(text);
+            record.fields.clear();
+            for (const auto& field : fields) {
+                record.fields.add(field);
+            }
+        };
+        // Очередь заполнена - ждём потребителя, записи не теряются
+        while (!queue_->tryPushWith(fill)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void workerLoop() {
+        int idle_rounds = 0;
+        for (;;) {
+            // Аварийный сброс: поток больше не трогает очередь и обработчики,
+            // процесс завершится после обработчика сигнала
+            if (crash_stop_.load(std::memory_order_acquire)) {
+                worker_parked_.store(true, std::memory_order_release);
+                for (;;) {
+                    std::this_thread::sleep_for(std::chrono::seconds(1));
+                }
+            }
+            // Сброс выполняем в фоновом потоке, чтобы не гоняться с handle()
+            std::size_t flush_request = flush_requested_.load(std::memory_order_acquire);
+            if (flush_request != flush_done_.load(std::memory_order_relaxed)) {
+                flushHandlers();
+                flush_done_.store(flush_request, std::memory_order_release);
+            }
+            bool consumed = queue_->tryConsume([this](LogRecord& record) {
+                dispatch(record.level, record.timestamp_ns, record.text, record.fields);
+            });
+            if (consumed) {
+                processed_.fetch_add(1, std::memory_order_release);
+                idle_rounds = 0;
+                continue;
+            }
+            if (!running_.load(std::memory_order_acquire) &&
+                queue_->sizeApprox() == 0) {
+                flushHandlers();
+                return;
+            }
+            // Очередь пуста: сначала крутимся, потом уступаем процессор, потом спим
+            ++idle_rounds;
+            if (idle_rounds > 64) {
+                releaseBursts(true);
+            }
+            if (idle_rounds > 256) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            } else if (idle_rounds > 64) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+public:
+    Logger() = default;
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    ~Logger() {
+        metrics_exporter_.reset(); // читает обработчики и очередь
+        if (crash_flush_) {
+            CrashFlush::remove(this);
+        }
+        stopAsync();
+        releaseBursts(false);
+    }
+
+    // Добавление фильтров, форматтеров и обработчиков
+    void addFilter(std::unique_ptr<ILogFilter> filter) {
+        int floor = static_cast<int>(filter->minimumLevel());
+        if (floor > min_level_.load(std::memory_order_relaxed)) {
+            min_level_.store(floor, std::memory_order_relaxed);
+        }
+        if (metrics_) {
+            metrics_->filters.push_back(std::make_unique<FilterMetrics>(metricsTypeName(typeid(*filter))));
+        }
+        filters_.push_back(std::move(filter));
+    }
+
+    // Можно вызывать из любого потока во время работы
+    void setMinLevel(LogLevel level) {
+        min_level_.store(static_cast<int>(level), std::memory_order_relaxed);
+    }
+
+    bool isEnabled(LogLevel log_level) const {
+        return static_cast<int>(log_level) >= min_level_.load(std::memory_order_relaxed);
+    }
+    
+    void addFormatter(std::unique_ptr<ILogFormatter> formatter) {
+        if (clock_ == nullptr) {
+            clock_ = formatter->clock();
+        }
+        formatters_.push_back(std::move(formatter));
+    }
+    
+    void addHandler(std::unique_ptr<ILogHandler> handler) {
+        if (metrics_) {
+            metrics_->handlers.push_back(std::make_unique<HandlerMetrics>(metricsTypeName(typeid(*handler))));
+        }
+        handlers_.push_back(std::move(handler));
+    }
+    
+    // Включение асинхронного режима. Фильтры, форматтеры и обработчики
+    // нужно добавить до вызова, дальше их использует только фоновый поток
+    void startAsync(std::size_t capacity = 8192) {
+        if (queue_) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            queue_ = std::make_unique<MpscRing<LogRecord>>(capacity);
+        }
+        running_.store(true, std::memory_order_release);
+        worker_ = std::thread(&Logger::workerLoop, this);
+    }
+
+    // Дожидается обработки всех записей и возвращает синхронный режим
+    void stopAsync() {
+        if (!queue_) {
+            return;
+        }
+        running_.store(false, std::memory_order_release);
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            queue_.reset();
+        }
+        processed_.store(0, std::memory_order_relaxed);
+    }
+
+    // Блокирует вызывающий поток, пока не будут обработаны все записи,
+    // поставленные в очередь до вызова, и сброшены обработчики
+    void flush() {
+        if (!queue_) {
+            flushHandlers();
+            return;
+        }
+        std::size_t target = queue_->pushedCount();
+        while (processed_.load(std::memory_order_acquire) < target) {
+            std::this_thread::yield();
+        }
+        std::size_t request = flush_requested_.fetch_add(1, std::memory_order_acq_rel) + 1;
+        while (flush_done_.load(std::memory_order_acquire) < request) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Основной метод логирования
+    void log(LogLevel log_level, const std::string& text) {
+        logRecord(log_level, text, {});
+    }
+
+    // Структурированная запись: поля кодируются в двоичный вид внутри записи,
+    // в текст или JSON их превращает только обработчик
+    void log(LogLevel log_level, const std::string& text, std::initializer_list<LogField> fields) {
+        logRecord(log_level, text, fields);
+    }
+
+    // Дочерний логгер с именем вида "net.http"; один и тот же объект на имя.
+    // Ссылку стоит сохранить: поиск по имени идёт под мьютексом
+    ModuleLogger& getLogger(const std::string& name);
+
+    // Уровень модуля и всех его потомков без своей настройки; "" или "root" -
+    // корневой логгер. Можно вызывать из любого потока во время работы.
+    // Единственная проверка уровня для модулей - уровень root, а не
+    // LevelFilter: фильтр отбросил бы и записи модулей с уровнем DEBUG
+    void setModuleLevel(const std::string& name, LogLevel level) {
+        std::lock_guard<std::mutex> lock(modules_mutex_);
+        levelsLocked().set(name, static_cast<int>(level));
+    }
+
+    // Уровни из файла (см. level_config.hpp) с перечитыванием при каждом его
+    // изменении. Ошибка в исходном файле - исключение std::runtime_error,
+    // при перечитывании - сообщение в std::cerr и прежние уровни
+    void configureLevels(const std::string& path) {
+        std::lock_guard<std::mutex> lock(modules_mutex_);
+        LevelRegistry& levels = levelsLocked();
+        std::string error;
+        if (!levels.load(path, error)) {
+            throw std::runtime_error(error);
+        }
+        levels.watch(path, [](const std::string& reload_error) {
+            std::cerr << "[LEVELS] " << reload_error << std::endl;
+        });
+    }
+
+    // Сворачивание серий одинаковых записей подряд (см. burst_dedup.hpp):
+    // повторы в течение window после первой записи заменяются одной записью
+    // "last message repeated N times". В асинхронном режиме сводка по истёкшей
+    // серии выводится фоновым потоком сразу, в синхронном - при следующем
+    // log() или flush(). Вызывать до начала логирования
+    void enableDeduplication(DedupMode mode = DedupMode::EXACT,
+                             std::chrono::milliseconds window = std::chrono::seconds(30)) {
+        dedup_ = std::make_unique<BurstDeduplicator>(
+            mode, std::chrono::duration_cast<std::chrono::nanoseconds>(window).count());
+    }
+
+    // Аварийный сброс (см. crash_flush.hpp): при SIGSEGV, SIGBUS, SIGFPE,
+    // SIGILL и SIGABRT буферы обработчиков и записи из очереди асинхронного
+    // режима пишутся в файлы через write(2), после чего процесс завершается
+    // как обычно. Вызывать после добавления обработчиков, из основного потока
+    void enableCrashFlush() {
+        if (crash_flush_) {
+            return;
+        }
+        CrashFlush::install();
+        crash_flush_ = CrashFlush::add(this);
+    }
+
+    // Счётчики пропущенных и отсеянных каждым фильтром записей и время
+    // handleRecord каждого обработчика (два чтения steady_clock на вызов).
+    // Вызывать до начала логирования
+    void enableMetrics() {
+        if (metrics_) {
+            return;
+        }
+        auto metrics = std::make_unique<Metrics>();
+        for (const auto& filter : filters_) {
+            metrics->filters.push_back(std::make_unique<FilterMetrics>(metricsTypeName(typeid(*filter))));
+        }
+        for (const auto& handler : handlers_) {
+            metrics->handlers.push_back(std::make_unique<HandlerMetrics>(metricsTypeName(typeid(*handler))));
+        }
+        metrics_ = std::move(metrics);
+    }
+
+    // Срез метрик; можно вызывать из любого потока. Без enableMetrics
+    // заполнены только очередь, потери, байты и ошибки записи
+    MetricsSnapshot metricsSnapshot() const {
+        MetricsSnapshot snapshot;
+        snapshot.timestamp_ns = nowNs();
+        if (metrics_) {
+            snapshot.records = metrics_->records.load(std::memory_order_relaxed);
+            for (const auto& filter : metrics_->filters) {
+                snapshot.filters.push_back({filter->name, filter->accepted.load(std::memory_order_relaxed),
+                                            filter->filtered.load(std::memory_order_relaxed)});
+            }
+        }
+        for (std::size_t i = 0; i < handlers_.size(); ++i) {
+            MetricsSnapshot::Handler handler;
+            if (metrics_) {
+                const AtomicLatencyHistogram& latency = metrics_->handlers[i]->latency;
+                handler.name = metrics_->handlers[i]->name;
+                handler.records = latency.count();
+                handler.total_ns = latency.sum();
+                handler.p50_ns = latency.percentile(0.5);
+                handler.p99_ns = latency.percentile(0.99);
+                handler.max_ns = latency.max();
+            } else {
+                handler.name = metricsTypeName(typeid(*handlers_[i]));
+            }
+            handler.dropped = handlers_[i]->recordsDropped();
+            handler.bytes = handlers_[i]->bytesWritten();
+            handler.write_errors = handlers_[i]->writeErrors();
+            snapshot.dropped += handler.dropped;
+            snapshot.write_errors += handler.write_errors;
+            snapshot.bytes_written += handler.bytes;
+            snapshot.handlers.push_back(std::move(handler));
+        }
+        if (binary_log_) {
+            snapshot.bytes_written += binary_log_->bytesWritten();
+        }
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex_);
+            if (queue_) {
+                snapshot.queue_depth = queue_->sizeApprox();
+                snapshot.queue_capacity = queue_->capacity();
+            }
+        }
+        return snapshot;
+    }
+
+    // Включает метрики и раз в interval записывает их срез в path
+    // (TEXT - в стиле Prometheus textfile, JSON - один объект)
+    void exportMetrics(const std::string& path,
+                       std::chrono::milliseconds interval = std::chrono::seconds(10),
+                       MetricsFormat format = MetricsFormat::TEXT) {
+        enableMetrics();
+        metrics_exporter_.reset();
+        metrics_exporter_ = std::make_unique<MetricsExporter>(path, interval, format,
+                                                              [this] { return metricsSnapshot(); });
+    }
+
+    // Отложенное форматирование: вместо текста пишутся id формата, время и
+    // байты аргументов, текст восстанавливает tools/log_decode. Записи идут
+    // мимо фильтров (кроме уровня), форматтеров и обработчиков.
+    // Вызывать до начала логирования
+    void enableBinaryLog(const std::string& path) {
+        binary_log_ = std::make_unique<BinaryLogWriter>(path);
+    }
+
+    // Вызывается через LOG_DEFERRED: format_source - лямбда без захвата,
+    // своя в каждом месте вызова, поэтому формат регистрируется один раз
+    template<typename FormatSource, typename... Args>
+    void logDeferred(FormatSource format_source, LogLevel log_level, const Args&... args) {
+        static_assert(FormatString::check<Args...>(format_source));
+        if (!isEnabled(log_level)) {
+            return;
+        }
+        static const DeferredFormat* format = DeferredFormatRegistry::instance().intern(
+            format_source(), DeferredArgs::signature<Args...>());
+        char encoded[DeferredArgs::MaxArgsSize];
+        std::size_t size = DeferredArgs::encode(encoded, args...);
+        if (binary_log_ && format != nullptr) {
+            std::int64_t timestamp_ns = nowNs();
+            binary_log_->write(*format, static_cast<std::uint8_t>(log_level), timestamp_ns, encoded, size);
+            return;
+        }
+        std::string text;
+        DeferredArgs::render(format_source(), DeferredArgs::signature<Args...>(), encoded, size, text);
+        log(log_level, text);
+    }
+
+    // Форматирование со строкой, проверенной при компиляции (см. format_string.hpp):
+    // LOGF_INFO(logger, "user {} took {} us", id, t). Строка разбирается один раз
+    // для места вызова, при выводе подставляются только аргументы
+    template<typename FormatSource, typename... Args>
+    void logFormat(FormatSource format_source, LogLevel log_level, const Args&... args) {
+        static_assert(FormatString::check<Args...>(format_source));
+        constexpr std::string_view format = format_source();
+        static constexpr auto parsed = FormatString::parse<FormatString::opCount(format)>(format);
+        if (!isEnabled(log_level)) {
+            return;
+        }
+        std::string text;
+        text.reserve(format.size() + 16 * sizeof...(Args));
+        FormatString::render(text, format, parsed, args...);
+        log(log_level, text);
+    }
+
+    // Ленивое логирование: make_message() вызывается, только если уровень включен
+    template<typename MessageFactory,
+             typename = std::enable_if_t<std::is_invocable_v<MessageFactory&>>>
+    void log(LogLevel log_level, MessageFactory&& make_message) {
+        if (isEnabled(log_level)) {
+            log(log_level, std::string(make_message()));
+        }
+    }
+
+    // Удобные методы для разных уровней логирования
+    void log_debug(const std::string& text) {
+        log(LogLevel::DEBUG, text);
+    }
+
+    void log_info(const std::string& text) {
+        log(LogLevel::INFO, text);
+    }
+    
+    void log_warn(const std::string& text) {
+        log(LogLevel::WARN, text);
+    }
+    
+    void log_error(const std::string& text) {
+        log(LogLevel::ERROR, text);
+    }
+
+    void log_debug(const std::string& text, std::initializer_list<LogField> fields) {
+        log(LogLevel::DEBUG, text, fields);
+    }
+
+    void log_info(const std::string& text, std::initializer_list<LogField> fields) {
+        log(LogLevel::INFO, text, fields);
+    }
+
+    void log_warn(const std::string& text, std::initializer_list<LogField> fields) {
+        log(LogLevel::WARN, text, fields);
+    }
+
+    void log_error(const std::string& text, std::initializer_list<LogField> fields) {
+        log(LogLevel::ERROR, text, fields);
+    }
+
+    template<typename MessageFactory,
+             typename = std::enable_if_t<std::is_invocable_v<MessageFactory&>>>
+    void log_debug(MessageFactory&& make_message) {
+        log(LogLevel::DEBUG, std::forward<MessageFactory>(make_message));
+    }
+
+    template<typename MessageFactory,
+             typename = std::enable_if_t<std::is_invocable_v<MessageFactory&>>>
+    void log_info(MessageFactory&& make_message) {
+        log(LogLevel::INFO, std::forward<MessageFactory>(make_message));
+    }
+
+    template<typename MessageFactory,
+             typename = std::enable_if_t<std::is_invocable_v<MessageFactory&>>>
+    void log_warn(MessageFactory&& make_message) {
+        log(LogLevel::WARN, std::forward<MessageFactory>(make_message));
+    }
+
+    template<typename MessageFactory,
+             typename = std::enable_if_t<std::is_invocable_v<MessageFactory&>>>
+    void log_error(MessageFactory&& make_message) {
+        log(LogLevel::ERROR, std::forward<MessageFactory>(make_message));
+    }
+};
+
+inline ModuleLogger& Logger::getLogger(const std::string& name) {
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    auto found = modules_.find(name);
+    if (found != modules_.end()) {
+        return *found->second;
+    }
+    auto module = std::make_unique<ModuleLogger>(this, name);
+    levelsLocked().attach(name, &module->min_level_);
+    ModuleLogger& result = *module;
+    modules_.emplace(name, std::move(module));
+    return result;
+}
+
+inline void ModuleLogger::write(LogLevel log_level, const std::string& text, std::initializer_list<LogField> fields) {
+    static thread_local std::string scratch;
+    static thread_local bool busy = false;
+    std::string nested; // если обработчик сам пишет в дочерний логгер
+    std::string& prefixed = busy ? nested : scratch;
+    bool outer = !busy;
+    busy = true;
+    prefixed.assign(prefix_);
+    prefixed += text;
+    parent_->submit(log_level, prefixed, fields);
+    if (outer) {
+        busy = false;
+    }
+}
+
+inline ModuleLogger& ModuleLogger::child(const std::string& suffix) {
+    return parent_->getLogger(name_ + "." + suffix);
+}
+
+// Аргументы макросов вычисляются только при включенном уровне:
+// LOG_DEBUG(logger, "value = " + std::to_string(expensive()));
+#if defined(__GNUC__) || defined(__clang__)
+#define LOGGER_UNLIKELY(condition) __builtin_expect(!!(condition), 0)
+#else
+#define LOGGER_UNLIKELY(condition) (condition)
+#endif
+
+#define LOG_AT(logger, level, message)                      \
+    do {                                                    \
+        if (LOGGER_UNLIKELY((logger).isEnabled(level))) {   \
+            (logger).log((level), (message));               \
+        }                                                   \
+    } while (0)
+
+#define LOG_DEBUG(logger, message) LOG_AT(logger, LogLevel::DEBUG, message)
+#define LOG_INFO(logger, message) LOG_AT(logger, LogLevel::INFO, message)
+#define LOG_WARN(logger, message) LOG_AT(logger, LogLevel::WARN, message)
+#define LOG_ERROR(logger, message) LOG_AT(logger, LogLevel::ERROR, message)
+
+// Строка формата проверяется при компиляции: число и типы аргументов
+// должны совпадать с подстановками. Аргументы вычисляются, только если уровень включен
+#define LOGF_AT(logger, level, format, ...)                                                      \
+    do {                                                                                          \
+        if (LOGGER_UNLIKELY((logger).isEnabled(level))) {                                         \
+            (logger).logFormat([] { return std::string_view(format); }, (level), ##__VA_ARGS__); \
+        }                                                                                         \
+    } while (0)
+
+#define LOGF_DEBUG(logger, format, ...) LOGF_AT(logger, LogLevel::DEBUG, format, ##__VA_ARGS__)
+#define LOGF_INFO(logger, format, ...) LOGF_AT(logger, LogLevel::INFO, format, ##__VA_ARGS__)
+#define LOGF_WARN(logger, format, ...) LOGF_AT(logger, LogLevel::WARN, format, ##__VA_ARGS__)
+#define LOGF_ERROR(logger, format, ...) LOGF_AT(logger, LogLevel::ERROR, format, ##__VA_ARGS__)
+
+// Отложенное форматирование: LOG_DEFERRED(logger, LogLevel::INFO, "user {} took {} us", id, t).
+// Формат должен быть строковым литералом
+#define LOG_DEFERRED(logger, level, format, ...) \
+    (logger).logDeferred([] { return std::string_view(format); }, (level), ##__VA_ARGS__)
@@ -0,0 +1,300 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+// Гистограмма задержек без блокировок: на каждую степень двойки по 2^SubBits
+// корзин (погрешность до ~20%), значения пишутся relaxed-инкрементами
+// из любого числа потоков
+class AtomicLatencyHistogram {
+private:
+    static constexpr int SubBits = 2;
+    static constexpr std::uint64_t SubCount = 1u << SubBits;
+    static constexpr std::size_t BucketCount = (64 - SubBits + 1) * SubCount;
+
+    std::atomic<std::uint64_t> counts_[BucketCount] = {};
+    std::atomic<std::uint64_t> total_{0};
+    std::atomic<std::uint64_t> sum_{0};
+    std::atomic<std::uint64_t> max_{0};
+
+    static std::size_t bucketOf(std::uint64_t value) {
+        if (value < SubCount) {
+            return static_cast<std::size_t>(value);
+        }
+        // value >> shift лежит в [SubCount, 2 * SubCount): старший бит неявный
+        int shift = 63 - __builtin_clzll(value) - SubBits;
+        std::uint64_t mantissa = (value >> shift) - SubCount;
+        return static_cast<std::size_t>(shift + 1) * SubCount + static_cast<std::size_t>(mantissa);
+    }
+
+    // Наибольшее значение, попадающее в корзину
+    static std::uint64_t upperBound(std::size_t bucket) {
+        if (bucket < SubCount) {
+            return bucket;
+        }
+        std::size_t shift = bucket / SubCount - 1;
+        std::uint64_t lower = (SubCount + bucket % SubCount) << shift;
+        return lower + ((std::uint64_t(1) << shift) - 1);
+    }
+
+public:
+    void record(std::uint64_t value) {
+        counts_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        total_.fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        std::uint64_t current = max_.load(std::memory_order_relaxed);
+        while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    std::uint64_t count() const {
+        return total_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t sum() const {
+        return sum_.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t max() const {
+        return max_.load(std::memory_order_relaxed);
+    }
+
+    // Оценка сверху; во время записи счётчики читаются не согласованно,
+    // поэтому результат приблизительный
+    std::uint64_t percentile(double fraction) const {
+        std::uint64_t total = 0;
+        std::uint64_t counts[BucketCount];
+        for (std::size_t i = 0; i < BucketCount; ++i) {
+            counts[i] = counts_[i].load(std::memory_order_relaxed);
+            total += counts[i];
+        }
+        if (total == 0) {
+            return 0;
+        }
+        std::uint64_t target = static_cast<std::uint64_t>(fraction * static_cast<double>(total));
+        if (target == 0) {
+            target = 1;
+        }
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BucketCount; ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                return upperBound(i);
+            }
+        }
+        return max();
+    }
+};
+
+// Счётчики одного фильтра
+struct FilterMetrics {
+    std::string name;
+    std::atomic<std::uint64_t> accepted{0};
+    std::atomic<std::uint64_t> filtered{0};
+
+    explicit FilterMetrics(std::string filter_name) : name(std::move(filter_name)) {}
+};
+
+// Время handleRecord одного обработчика в наносекундах
+struct HandlerMetrics {
+    std::string name;
+    AtomicLatencyHistogram latency;
+
+    explicit HandlerMetrics(std::string handler_name) : name(std::move(handler_name)) {}
+};
+
+// Имя типа для подписи метрик: "FileHandler", "LevelFilter"
+inline std::string metricsTypeName(const std::type_info& type) {
+#ifdef __GNUG__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled != nullptr) {
+        std::string name(demangled);
+        std::free(demangled);
+        return name;
+    }
+#endif
+    return type.name();
+}
+
+enum class MetricsFormat {
+    TEXT, // по строке на значение, как в Prometheus
+    JSON  // один объект
+};
+
+// Согласованный на момент чтения (по каждому счётчику в отдельности) срез метрик
+struct MetricsSnapshot {
+    struct Filter {
+        std::string name;
+        std::uint64_t accepted = 0;
+        std::uint64_t filtered = 0;
+    };
+
+    struct Handler {
+        std::string name;
+        std::uint64_t records = 0;
+        std::uint64_t total_ns = 0;
+        std::uint64_t p50_ns = 0;
+        std::uint64_t p99_ns = 0;
+        std::uint64_t max_ns = 0;
+        std::uint64_t dropped = 0;
+        std::uint64_t bytes = 0;
+        std::uint64_t write_errors = 0;
+    };
+
+    std::int64_t timestamp_ns = 0;
+    std::uint64_t records = 0;        // записи, дошедшие до фильтров
+    std::uint64_t queue_depth = 0;    // асинхронный режим: ждут фонового потока
+    std::uint64_t queue_capacity = 0;
+    std::uint64_t dropped = 0;        // сумма по обработчикам
+    std::uint64_t bytes_written = 0;  // сумма по обработчикам и двоичному журналу
+    std::uint64_t write_errors = 0;   // сумма по обработчикам
+    std::vector<Filter> filters;
+    std::vector<Handler> handlers;
+
+    std::string toText() const {
+        std::string out;
+        auto line = [&out](const std::string& name, const std::string& labels, std::uint64_t value) {
+            out += name;
+            if (!labels.empty()) {
+                out += '{';
+                out += labels;
+                out += '}';
+            }
+            out += ' ';
+            out += std::to_string(value);
+            out += '\n';
+        };
+        line("logger_records_total", "", records);
+        line("logger_queue_depth", "", queue_depth);
+        line("logger_queue_capacity", "", queue_capacity);
+        line("logger_dropped_total", "", dropped);
+        line("logger_bytes_written_total", "", bytes_written);
+        line("logger_write_errors_total", "", write_errors);
+        for (std::size_t i = 0; i < filters.size(); ++i) {
+            std::string labels = "filter=\"" + std::to_string(i) + ":" + filters[i].name + "\"";
+            line("logger_filter_accepted_total", labels, filters[i].accepted);
+            line("logger_filter_filtered_total", labels, filters[i].filtered);
+        }
+        for (std::size_t i = 0; i < handlers.size(); ++i) {
+            const Handler& handler = handlers[i];
+            std::string labels = "handler=\"" + std::to_string(i) + ":" + handler.name + "\"";
+            line("logger_handler_records_total", labels, handler.records);
+            line("logger_handler_latency_ns_sum", labels, handler.total_ns);
+            line("logger_handler_latency_ns", labels + ",quantile=\"0.5\"", handler.p50_ns);
+            line("logger_handler_latency_ns", labels + ",quantile=\"0.99\"", handler.p99_ns);
+            line("logger_handler_latency_ns_max", labels, handler.max_ns);
+            line("logger_handler_dropped_total", labels, handler.dropped);
+            line("logger_handler_bytes_total", labels, handler.bytes);
+            line("logger_handler_write_errors_total", labels, handler.write_errors);
+        }
+        return out;
+    }
+
+    std::string toJson() const {
+        std::string out = "{\"timestamp_ns\":" + std::to_string(timestamp_ns);
+        out += ",\"records\":" + std::to_string(records);
+        out += ",\"queue_depth\":" + std::to_string(queue_depth);
+        out += ",\"queue_capacity\":" + std::to_string(queue_capacity);
+        out += ",\"dropped\":" + std::to_string(dropped);
+        out += ",\"bytes_written\":" + std::to_string(bytes_written);
+        out += ",\"write_errors\":" + std::to_string(write_errors);
+        out += ",\"filters\":[";
+        for (std::size_t i = 0; i < filters.size(); ++i) {
+            out += i == 0 ? "{" : ",{";
+            out += "\"name\":\"" + filters[i].name + "\"";
+            out += ",\"accepted\":" + std::to_string(filters[i].accepted);
+            out += ",\"filtered\":" + std::to_string(filters[i].filtered) + "}";
+        }
+        out += "],\"handlers\":[";
+        for (std::size_t i = 0; i < handlers.size(); ++i) {
+            const Handler& handler = handlers[i];
+            out += i == 0 ? "{" : ",{";
+            out += "\"name\":\"" + handler.name + "\"";
+            out += ",\"records\":" + std::to_string(handler.records);
+            out += ",\"total_ns\":" + std::to_string(handler.total_ns);
+            out += ",\"p50_ns\":" + std::to_string(handler.p50_ns);
+            out += ",\"p99_ns\":" + std::to_string(handler.p99_ns);
+            out += ",\"max_ns\":" + std::to_string(handler.max_ns);
+            out += ",\"dropped\":" + std::to_string(handler.dropped);
+            out += ",\"bytes\":" + std::to_string(handler.bytes);
+            out += ",\"write_errors\":" + std::to_string(handler.write_errors) + "}";
+        }
+        out += "]}\n";
+        return out;
+    }
+};
+
+// Раз в interval записывает срез метрик в файл (целиком заменяя его через
+// rename, чтобы читатель не увидел половину), и ещё раз при остановке
+class MetricsExporter {
+private:
+    std::string path_;
+    std::chrono::milliseconds interval_;
+    MetricsFormat format_;
+    std::function<MetricsSnapshot()> source_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool stopping_ = false;
+    std::thread thread_;
+
+    void exportOnce() {
+        MetricsSnapshot snapshot = source_();
+        std::string content = format_ == MetricsFormat::JSON ? snapshot.toJson() : snapshot.toText();
+        std::string temporary = path_ + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "wb");
+        if (file == nullptr) {
+            return;
+        }
+        bool written = std::fwrite(content.data(), 1, content.size(), file) == content.size();
+        if (std::fclose(file) == 0 && written) {
+            std::rename(temporary.c_str(), path_.c_str());
+        }
+    }
+
+    void exportLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            wakeup_.wait_for(lock, interval_);
+            lock.unlock();
+            exportOnce();
+            lock.lock();
+        }
+    }
+
+public:
+    MetricsExporter(const std::string& path, std::chrono::milliseconds interval, MetricsFormat format,
+                    std::function<MetricsSnapshot()> source)
+        : path_(path), interval_(interval), format_(format), source_(std::move(source)) {
+        thread_ = std::thread(&MetricsExporter::exportLoop, this);
+    }
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    ~MetricsExporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+};
@@ -0,0 +1,344 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Быстрый LZ77-кодек в духе LZ4 без внешних зависимостей.
+//
+// Блок - последовательность команд: байт-токен (старшие 4 бита - длина
+// литералов, младшие - длина совпадения минус 4; значение 15 продолжается
+// байтами по 255), литералы, 2 байта смещения (LE), продолжение длины
+// совпадения. Последняя команда содержит только литералы.
+//
+// Файл (кадр): "LZLG" и далее блоки по до 64 КиБ исходных данных:
+// [uint32 размер данных блока | старший бит - блок хранится без сжатия]
+// [uint32 исходный размер] [данные]. Блок с размером 0 - конец файла.
+class LzCodec {
+private:
+    static constexpr int MinMatch = 4;
+    static constexpr int HashBits = 12;
+    static constexpr std::size_t LastLiterals = 5;   // хвост блока всегда литералами
+    static constexpr std::size_t MatchSearchLimit = 12;
+
+    static std::uint32_t read32(const std::uint8_t* p) {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    static std::uint32_t hash(std::uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HashBits);
+    }
+
+    static void writeLength(std::uint8_t*& out, std::size_t length) {
+        while (length >= 255) {
+            *out++ = 255;
+            length -= 255;
+        }
+        *out++ = static_cast<std::uint8_t>(length);
+    }
+
+public:
+    static constexpr std::size_t BlockSize = 64 * 1024;
+    static constexpr std::uint32_t StoredFlag = 0x80000000u;
+
+    // Размер буфера, достаточный для сжатия size байт в худшем случае
+    static std::size_t maxCompressedSize(std::size_t size) {
+        return size + size / 255 + 16;
+    }
+
+    // Сжимает блок (до BlockSize байт), возвращает размер результата
+    static std::size_t compressBlock(const std::uint8_t* src, std::size_t size, std::uint8_t* dst) {
+        std::uint16_t table[1 << HashBits];
+        std::memset(table, 0, sizeof(table));
+
+        std::uint8_t* out = dst;
+        std::size_t anchor = 0;
+        std::size_t pos = 0;
+
+        if (size > MatchSearchLimit) {
+            std::size_t match_limit = size - MatchSearchLimit;
+            pos = 1;
+            while (pos < match_limit) {
+                std::uint32_t sequence = read32(src + pos);
+                std::uint32_t h = hash(sequence);
+                std::size_t candidate = table[h];
+                table[h] = static_cast<std::uint16_t>(pos);
+                if (candidate >= pos || pos - candidate > 0xFFFF || read32(src + candidate) != sequence) {
+                    ++pos;
+                    continue;
+                }
+
+                // Расширяем совпадение назад по литералам и вперёд до хвоста
+                while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1]) {
+                    --pos;
+                    --candidate;
+                }
+                std::size_t match_end = pos + MinMatch;
+                std::size_t reference = candidate + MinMatch;
+                std::size_t end_limit = size - LastLiterals;
+                while (match_end < end_limit && src[match_end] == src[reference]) {
+                    ++match_end;
+                    ++reference;
+                }
+
+                std::size_t literals = pos - anchor;
+                std::size_t match_length = match_end - pos - MinMatch;
+                std::uint8_t* token = out++;
+                *token = static_cast<std::uint8_t>(((literals < 15 ? literals : 15) << 4) |
+                                                   (match_length < 15 ? match_length : 15));
+                if (literals >= 15) {
+                    writeLength(out, literals - 15);
+                }
+                std::memcpy(out, src + anchor, literals);
+                out += literals;
+                std::size_t offset = pos - candidate;
+                *out++ = static_cast<std::uint8_t>(offset & 0xFF);
+                *out++ = static_cast<std::uint8_t>(offset >> 8);
+                if (match_length >= 15) {
+                    writeLength(out, match_length - 15);
+                }
+
+                pos = match_end;
+                anchor = pos;
+                if (pos >= 2 && pos < match_limit) {
+                    table[hash(read32(src + pos - 2))] = static_cast<std::uint16_t>(pos - 2);
+                }
+            }
+        }
+
+        std::size_t literals = size - anchor;
+        *out++ = static_cast<std::uint8_t>((literals < 15 ? literals : 15) << 4);
+        if (literals >= 15) {
+            writeLength(out, literals - 15);
+        }
+        std::memcpy(out, src + anchor, literals);
+        out += literals;
+        return static_cast<std::size_t>(out - dst);
+    }
+
+    // Распаковывает блок; false - данные повреждены
+    static bool decompressBlock(const std::uint8_t* src, std::size_t size,
+                                std::uint8_t* dst, std::size_t raw_size) {
+        const std::uint8_t* in = src;
+        const std::uint8_t* in_end = src + size;
+        std::uint8_t* out = dst;
+        std::uint8_t* out_end = dst + raw_size;
+
+        auto readLength = [&](std::size_t& length) {
+            std::uint8_t extra;
+            do {
+                if (in >= in_end) {
+                    return false;
+                }
+                extra = *in++;
+                length += extra;
+            } while (extra == 255);
+            return true;
+        };
+
+        while (in < in_end) {
+            std::uint8_t token = *in++;
+            std::size_t literals = token >> 4;
+            if (literals == 15 && !readLength(literals)) {
+                return false;
+            }
+            if (literals > static_cast<std::size_t>(in_end - in) ||
+                literals > static_cast<std::size_t>(out_end - out)) {
+                return false;
+            }
+            std::memcpy(out, in, literals);
+            in += literals;
+            out += literals;
+            if (in == in_end) {
+                break; // последняя команда - только литералы
+            }
+
+            if (in_end - in < 2) {
+                return false;
+            }
+            std::size_t offset = in[0] | (static_cast<std::size_t>(in[1]) << 8);
+            in += 2;
+            std::size_t match_length = token & 0x0F;
+            if (match_length == 15 && !readLength(match_length)) {
+                return false;
+            }
+            match_length += MinMatch;
+            if (offset == 0 || offset > static_cast<std::size_t>(out - dst) ||
+                match_length > static_cast<std::size_t>(out_end - out)) {
+                return false;
+            }
+            // Побайтно: источник может перекрываться с приёмником
+            const std::uint8_t* match = out - offset;
+            for (std::size_t i = 0; i < match_length; ++i) {
+                out[i] = match[i];
+            }
+            out += match_length;
+        }
+        return out == out_end;
+    }
+
+    // Сжимает файл целиком; результат сначала пишется во временный файл
+    static bool compressFile(const std::string& source, const std::string& destination) {
+        std::FILE* in = std::fopen(source.c_str(), "rb");
+        if (in == nullptr) {
+            return false;
+        }
+        std::string temporary = destination + ".tmp";
+        std::FILE* out = std::fopen(temporary.c_str(), "wb");
+        if (out == nullptr) {
+            std::fclose(in);
+            return false;
+        }
+
+        std::vector<std::uint8_t> raw(BlockSize);
+        std::vector<std::uint8_t> packed(maxCompressedSize(BlockSize));
+        bool ok = std::fwrite("LZLG", 1, 4, out) == 4;
+        while (ok) {
+            std::size_t read = std::fread(raw.data(), 1, raw.size(), in);
+            if (read == 0) {
+                break;
+            }
+            std::size_t packed_size = compressBlock(raw.data(), read, packed.data());
+            std::uint32_t header[2];
+            const std::uint8_t* payload = packed.data();
+            if (packed_size >= read) {
+                header[0] = static_cast<std::uint32_t>(read) | StoredFlag;
+                payload = raw.data();
+                packed_size = read;
+            } else {
+                header[0] = static_cast<std::uint32_t>(packed_size);
+            }
+            header[1] = static_cast<std::uint32_t>(read);
+            ok = std::fwrite(header, sizeof(header), 1, out) == 1 &&
+                 std::fwrite(payload, 1, packed_size, out) == packed_size;
+        }
+        std::uint32_t end_marker[2] = {0, 0};
+        ok = ok && !std::ferror(in) && std::fwrite(end_marker, sizeof(end_marker), 1, out) == 1;
+        std::fclose(in);
+        ok = std::fclose(out) == 0 && ok;
+        if (!ok || std::rename(temporary.c_str(), destination.c_str()) != 0) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+// Потоковое чтение сжатого файла: в памяти держится только один блок
+class LzFileReader {
+private:
+    std::FILE* file_ = nullptr;
+    std::vector<std::uint8_t> raw_;
+    std::vector<std::uint8_t> packed_;
+    std::size_t position_ = 0;
+    bool finished_ = false;
+    bool corrupted_ = false;
+
+    bool nextBlock() {
+        std::uint32_t header[2];
+        if (std::fread(header, sizeof(header), 1, file_) != 1) {
+            corrupted_ = true;
+            return false;
+        }
+        if (header[0] == 0) {
+            finished_ = true;
+            return false;
+        }
+        bool stored = (header[0] & LzCodec::StoredFlag) != 0;
+        std::size_t size = header[0] & ~LzCodec::StoredFlag;
+        std::size_t raw_size = header[1];
+        if (raw_size > LzCodec::BlockSize || size > LzCodec::maxCompressedSize(LzCodec::BlockSize)) {
+            corrupted_ = true;
+            return false;
+        }
+        raw_.resize(raw_size);
+        position_ = 0;
+        if (stored) {
+            if (size != raw_size || std::fread(raw_.data(), 1, size, file_) != size) {
+                corrupted_ = true;
+                return false;
+            }
+            return true;
+        }
+        packed_.resize(size);
+        if (std::fread(packed_.data(), 1, size, file_) != size ||
+            !LzCodec::decompressBlock(packed_.data(), size, raw_.data(), raw_size)) {
+            corrupted_ = true;
+            return false;
+        }
+        return true;
+    }
+
+public:
+    explicit LzFileReader(const std::string& path) {
+        file_ = std::fopen(path.c_str(), "rb");
+        char magic[4];
+        if (file_ == nullptr || std::fread(magic, 1, 4, file_) != 4 || std::memcmp(magic, "LZLG", 4) != 0) {
+            corrupted_ = true;
+        }
+    }
+
+    LzFileReader(const LzFileReader&) = delete;
+    LzFileReader& operator=(const LzFileReader&) = delete;
+
+    ~LzFileReader() {
+        if (file_ != nullptr) {
+            std::fclose(file_);
+        }
+    }
+
+    bool good() const {
+        return !corrupted_;
+    }
+
+    // Читает до size байт; 0 - конец файла или ошибка (см. good())
+    std::size_t read(char* out, std::size_t size) {
+        std::size_t total = 0;
+        while (total < size && !corrupted_) {
+            if (position_ == raw_.size()) {
+                if (finished_ || !nextBlock()) {
+                    break;
+                }
+                continue;
+            }
+            std::size_t chunk = raw_.size() - position_;
+            if (chunk > size - total) {
+                chunk = size - total;
+            }
+            std::memcpy(out + total, raw_.data() + position_, chunk);
+            position_ += chunk;
+            total += chunk;
+        }
+        return total;
+    }
+
+    // Читает строку без '\n'; false - строк больше нет
+    bool getline(std::string& line) {
+        line.clear();
+        bool any = false;
+        while (!corrupted_) {
+            if (position_ == raw_.size()) {
+                if (finished_ || !nextBlock()) {
+                    break;
+                }
+                continue;
+            }
+            any = true;
+            const std::uint8_t* begin = raw_.data() + position_;
+            const void* newline = std::memchr(begin, '\n', raw_.size() - position_);
+            if (newline != nullptr) {
+                std::size_t length = static_cast<const std::uint8_t*>(newline) - begin;
+                line.append(reinterpret_cast<const char*>(begin), length);
+                position_ += length + 1;
+                return true;
+            }
+            line.append(reinterpret_cast<const char*>(begin), raw_.size() - position_);
+            position_ = raw_.size();
+        }
+        return any;
+    }
+};
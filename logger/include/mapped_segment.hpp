@@ -0,0 +1,212 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// Хвост сегмента: лежит в последних байтах файла после его заполнения
+struct SegmentFooter {
+    char magic[8];                   // "LOGSEG01"
+    std::uint64_t record_count;
+    std::int64_t first_timestamp_ns;
+    std::int64_t last_timestamp_ns;
+    std::uint64_t data_bytes;        // длина текстовой части от начала файла
+};
+
+// Запись логов в заранее выделенные сегменты фиксированного размера,
+// отображённые в память. Запись строки - это memcpy без системных вызовов;
+// системные вызовы нужны только при смене сегмента. Заполненный сегмент
+// закрывается хвостом SegmentFooter, хранится не более max_segments файлов
+// вида <base>.<номер>.seg, самые старые удаляются.
+// Незакрытый (после аварии) сегмент читается до первого нулевого байта.
+class MappedSegmentWriter {
+private:
+    static constexpr char Magic[8] = {'L', 'O', 'G', 'S', 'E', 'G', '0', '1'};
+
+    std::filesystem::path directory_;
+    std::string base_name_;
+    std::size_t segment_size_;
+    std::size_t max_segments_;
+
+    std::mutex mutex_;
+    int fd_ = -1;
+    char* map_ = nullptr;
+    std::size_t used_ = 0;
+    std::uint64_t next_sequence_ = 0;
+    std::deque<std::filesystem::path> segments_;
+    SegmentFooter footer_{};
+
+    std::size_t dataCapacity() const {
+        return segment_size_ - sizeof(SegmentFooter);
+    }
+
+    std::filesystem::path segmentPath(std::uint64_t sequence) const {
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%08llu.seg",
+                      static_cast<unsigned long long>(sequence));
+        return directory_ / (base_name_ + suffix);
+    }
+
+    // Находит уже существующие сегменты, чтобы продолжить нумерацию
+    void scanExisting() {
+        std::error_code error;
+        std::vector<std::pair<std::uint64_t, std::filesystem::path>> found;
+        for (const auto& entry : std::filesystem::directory_iterator(directory_, error)) {
+            std::string name = entry.path().filename().string();
+            std::string prefix = base_name_ + ".";
+            if (name.size() != prefix.size() + 12 || name.compare(0, prefix.size(), prefix) != 0 ||
+                name.compare(name.size() - 4, 4, ".seg") != 0) {
+                continue;
+            }
+            std::string digits = name.substr(prefix.size(), 8);
+            if (digits.find_first_not_of("0123456789") != std::string::npos) {
+                continue;
+            }
+            found.emplace_back(std::stoull(digits), entry.path());
+        }
+        std::sort(found.begin(), found.end());
+        for (auto& item : found) {
+            segments_.push_back(item.second);
+            next_sequence_ = item.first + 1;
+        }
+    }
+
+    bool openSegment() {
+        std::filesystem::path path = segmentPath(next_sequence_++);
+        fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            return false;
+        }
+        // Выделяем место сразу, чтобы запись в отображение не упёрлась в ENOSPC (SIGBUS).
+        // Без выделенного места сегмент не открываем: разреженный файл
+        // после ftruncate снова даёт SIGBUS при заполнении диска
+        if (::posix_fallocate(fd_, 0, static_cast<off_t>(segment_size_)) != 0) {
+            ::close(fd_);
+            fd_ = -1;
+            std::error_code error;
+            std::filesystem::remove(path, error);
+            return false;
+        }
+        int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE; // страницы подгружаются при смене сегмента, а не на горячем пути
+#endif
+        void* map = ::mmap(nullptr, segment_size_, PROT_READ | PROT_WRITE, flags, fd_, 0);
+        if (map == MAP_FAILED) {
+            ::close(fd_);
+            fd_ = -1;
+            return false;
+        }
+        map_ = static_cast<char*>(map);
+        used_ = 0;
+        footer_ = SegmentFooter{};
+        std::memcpy(footer_.magic, Magic, sizeof(Magic));
+
+        segments_.push_back(path);
+        while (segments_.size() > max_segments_) {
+            std::error_code error;
+            std::filesystem::remove(segments_.front(), error);
+            segments_.pop_front();
+        }
+        return true;
+    }
+
+    void closeSegment() {
+        if (map_ == nullptr) {
+            return;
+        }
+        footer_.data_bytes = used_;
+        std::memcpy(map_ + dataCapacity(), &footer_, sizeof(footer_));
+        ::msync(map_, segment_size_, MS_ASYNC);
+        ::munmap(map_, segment_size_);
+        ::close(fd_);
+        map_ = nullptr;
+        fd_ = -1;
+    }
+
+public:
+    MappedSegmentWriter(const std::string& directory, const std::string& base_name,
+                        std::size_t segment_size, std::size_t max_segments)
+        : directory_(directory), base_name_(base_name),
+          segment_size_(segment_size), max_segments_(max_segments > 0 ? max_segments : 1) {
+        if (segment_size_ < 4096) {
+            throw std::invalid_argument("segment size must be at least 4096 bytes");
+        }
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+        scanExisting();
+        openSegment();
+    }
+
+    MappedSegmentWriter(const MappedSegmentWriter&) = delete;
+    MappedSegmentWriter& operator=(const MappedSegmentWriter&) = delete;
+
+    ~MappedSegmentWriter() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closeSegment();
+    }
+
+    bool isOpen() const {
+        return map_ != nullptr;
+    }
+
+    // Добавляет строку; слишком длинная запись обрезается до размера сегмента
+    void appendLine(std::int64_t timestamp_ns, const char* data, std::size_t size) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (map_ == nullptr) {
+            return;
+        }
+        if (size + 1 > dataCapacity()) {
+            size = dataCapacity() - 1;
+        }
+        if (used_ + size + 1 > dataCapacity()) {
+            closeSegment();
+            if (!openSegment()) {
+                return;
+            }
+        }
+        std::memcpy(map_ + used_, data, size);
+        map_[used_ + size] = '\n';
+        used_ += size + 1;
+
+        if (footer_.record_count == 0) {
+            footer_.first_timestamp_ns = timestamp_ns;
+        }
+        footer_.last_timestamp_ns = timestamp_ns;
+        ++footer_.record_count;
+    }
+
+    // Асинхронно отдаёт записанные страницы ядру на сброс
+    void sync() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (map_ != nullptr && used_ > 0) {
+            ::msync(map_, used_, MS_ASYNC);
+        }
+    }
+
+    // Читает хвост закрытого сегмента; false - сегмент не закрыт или повреждён
+    static bool readFooter(const std::string& path, SegmentFooter& footer) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        off_t size = ::lseek(fd, 0, SEEK_END);
+        bool ok = size >= static_cast<off_t>(sizeof(SegmentFooter)) &&
+                  ::pread(fd, &footer, sizeof(footer), size - static_cast<off_t>(sizeof(footer))) ==
+                      static_cast<ssize_t>(sizeof(footer)) &&
+                  std::memcmp(footer.magic, Magic, sizeof(Magic)) == 0;
+        ::close(fd);
+        return ok;
+    }
+};
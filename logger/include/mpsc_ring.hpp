@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Ограниченная lock-free очередь: много производителей, один потребитель.
+// У каждой ячейки свой счётчик последовательности, поэтому производители
+// конкурируют только за один fetch-CAS по head_, а потребитель вообще
+// не выполняет атомарных RMW-операций.
+template<typename T>
+class MpscRing {
+private:
+    static constexpr std::size_t CacheLine = 64;
+
+    struct alignas(CacheLine) Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_;
+
+    alignas(CacheLine) std::atomic<std::size_t> head_{0};
+    alignas(CacheLine) std::atomic<std::size_t> tail_{0};
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+        std::size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+public:
+    explicit MpscRing(std::size_t capacity)
+        : slots_(new Slot[roundUpToPowerOfTwo(capacity)]),
+          mask_(roundUpToPowerOfTwo(capacity) - 1) {
+        for (std::size_t i = 0; i <= mask_; ++i) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    std::size_t capacity() const {
+        return mask_ + 1;
+    }
+
+    // Возвращает false, если очередь заполнена; значение при этом не перемещается
+    bool tryPush(T&& value) {
+        return tryPushWith([&value](T& slot_value) { slot_value = std::move(value); });
+    }
+
+    // Заполняет ячейку на месте: fill(T&) может переиспользовать память,
+    // оставшуюся в ячейке от предыдущей записи
+    template<typename F>
+    bool tryPushWith(F&& fill) {
+        std::size_t pos = head_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = head_.load(std::memory_order_relaxed);
+            }
+        }
+        fill(slot->value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Вызывается только из потока-потребителя
+    bool tryPop(T& out) {
+        return tryConsume([&out](T& slot_value) { out = std::move(slot_value); });
+    }
+
+    // Обрабатывает запись прямо в ячейке, без перемещения
+    template<typename F>
+    bool tryConsume(F&& consume) {
+        std::size_t pos = tail_.load(std::memory_order_relaxed);
+        Slot& slot = slots_[pos & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        consume(slot.value);
+        slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        tail_.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Обходит опубликованные, но ещё не извлечённые записи, ничего не меняя.
+    // Только атомарные чтения, поэтому годится для обработчика сигнала;
+    // запись, которую потребитель обрабатывает прямо сейчас, тоже попадёт в обход
+    template<typename F>
+    void forEachPending(F&& visit) const {
+        std::size_t head = head_.load(std::memory_order_acquire);
+        for (std::size_t pos = tail_.load(std::memory_order_acquire); pos != head; ++pos) {
+            const Slot& slot = slots_[pos & mask_];
+            if (slot.sequence.load(std::memory_order_acquire) == pos + 1) {
+                visit(slot.value);
+            }
+        }
+    }
+
+    // Сколько записей было поставлено в очередь за всё время
+    std::size_t pushedCount() const {
+        return head_.load(std::memory_order_acquire);
+    }
+
+    // Сколько записей было извлечено потребителем за всё время
+    std::size_t poppedCount() const {
+        return tail_.load(std::memory_order_acquire);
+    }
+
+    std::size_t sizeApprox() const {
+        std::size_t head = pushedCount();
+        std::size_t tail = poppedCount();
+        return head > tail ? head - tail : 0;
+    }
+};
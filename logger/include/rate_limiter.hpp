@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// Набор ограничителей скорости по ключу без блокировок. Каждый ключ
+// попадает в одну из slot_count ячеек (ключи с одинаковым хэшем делят
+// ячейку). Ячейка - алгоритм GCRA, эквивалентный корзине токенов:
+// хранится только "теоретическое время прихода" следующей записи, поэтому
+// состояние помещается в один атомарный int64 и обновляется одним CAS.
+class KeyedRateLimiter {
+private:
+    std::unique_ptr<std::atomic<std::int64_t>[]> slots_;
+    std::size_t mask_;
+    std::int64_t interval_ns_;  // время на один токен
+    std::int64_t tolerance_ns_; // запас на всплеск: (burst - 1) интервалов
+
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool isAlnum(char c) {
+        return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+    }
+
+    static bool isHexNumber(std::string_view word) {
+        if (word.size() > 2 && word[0] == '0' && (word[1] == 'x' || word[1] == 'X')) {
+            word.remove_prefix(2);
+        }
+        bool has_digit = false;
+        for (char c : word) {
+            bool hex_letter = (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+            if (!isDigit(c) && !hex_letter) {
+                return false;
+            }
+            has_digit = has_digit || isDigit(c);
+        }
+        return has_digit;
+    }
+
+public:
+    // rate_per_second - средняя скорость на ключ, burst - сколько записей
+    // подряд пропускается после паузы
+    KeyedRateLimiter(double rate_per_second, std::size_t burst, std::size_t slot_count = 4096) {
+        std::size_t slots = 1;
+        while (slots < slot_count) {
+            slots <<= 1;
+        }
+        mask_ = slots - 1;
+        slots_.reset(new std::atomic<std::int64_t>[slots]);
+        for (std::size_t i = 0; i < slots; ++i) {
+            slots_[i].store(0, std::memory_order_relaxed);
+        }
+        interval_ns_ = rate_per_second > 0 ? static_cast<std::int64_t>(1e9 / rate_per_second) : 0;
+        tolerance_ns_ = interval_ns_ * static_cast<std::int64_t>(burst > 0 ? burst - 1 : 0);
+    }
+
+    // true - запись укладывается в лимит своего ключа
+    bool tryAcquire(std::uint64_t key, std::int64_t now_ns) {
+        if (interval_ns_ == 0) {
+            return true;
+        }
+        std::atomic<std::int64_t>& slot = slots_[key & mask_];
+        std::int64_t tat = slot.load(std::memory_order_relaxed);
+        for (;;) {
+            std::int64_t start = tat > now_ns ? tat : now_ns;
+            if (start - now_ns > tolerance_ns_) {
+                return false; // корзина пуста
+            }
+            if (slot.compare_exchange_weak(tat, start + interval_ns_, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    // Хэш "шаблона" сообщения: переменные части заменяются одним символом,
+    // поэтому "user 42 took 17 us" и "user 7 took 3 us" дают один ключ.
+    // Переменной считается серия цифр, а также слово из шестнадцатеричных
+    // цифр, в котором есть хотя бы одна десятичная ("0x7ffe12", "a3f9e0",
+    // части UUID). Слова только из букв ("deadbeef") и прочие переменные
+    // части (имена, пути, строки в кавычках) остаются в ключе, и такие
+    // сообщения расходятся по разным ключам
+    static std::uint64_t templateKey(std::string_view text, std::uint64_t seed = 0) {
+        std::uint64_t hash = 14695981039346656037ull ^ seed; // FNV-1a
+        auto mix = [&hash](char c) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        };
+        std::size_t i = 0;
+        while (i < text.size()) {
+            if (!isAlnum(text[i])) {
+                mix(text[i++]);
+                continue;
+            }
+            std::size_t end = i;
+            while (end < text.size() && isAlnum(text[end])) {
+                ++end;
+            }
+            if (isHexNumber(text.substr(i, end - i))) {
+                mix('#');
+                i = end;
+                continue;
+            }
+            bool in_number = false;
+            for (; i < end; ++i) {
+                bool digit = isDigit(text[i]);
+                if (!(digit && in_number)) {
+                    mix(digit ? '#' : text[i]);
+                }
+                in_number = digit;
+            }
+        }
+        return hash ^ (hash >> 29);
+    }
+};
@@ -0,0 +1,682 @@
+#pragma once
+#include <algorithm>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Регулярные выражения без возвратов для фильтрации логов.
+// Поддерживаемое подмножество: литералы, '.', классы [a-z] и [^...],
+// \d \w \s (и \D \W \S), группы (...) и (?:...), альтернатива '|',
+// повторения * + ? {m} {m,} {m,n} (ленивые формы допускаются), якоря ^ и $.
+// Шаблон компилируется в NFA Томпсона, из которого заранее строится DFA
+// над классами эквивалентности байтов, поэтому поиск линеен по длине текста.
+// Если DFA получается слишком большим, используется симуляция NFA - тоже
+// линейная по тексту. search() не меняет объект и безопасен из нескольких потоков.
+class CompiledRegex {
+private:
+    using ByteSet = std::bitset<256>;
+
+    struct AstNode {
+        enum class Kind { EMPTY, SET, CONCAT, ALTERNATION, REPEAT, BEGIN, END };
+        Kind kind = Kind::EMPTY;
+        int set = -1;
+        int min = 0;
+        int max = 0; // -1 - без ограничения
+        std::vector<int> children;
+    };
+
+    struct NfaNode {
+        enum class Kind { SET, SPLIT, BEGIN, END, MATCH };
+        Kind kind = Kind::MATCH;
+        int set = -1;
+        int out = -1;
+        int out1 = -1;
+    };
+
+    static constexpr int MaxRepeat = 1000;
+    static constexpr std::size_t MaxNfaNodes = 100000;
+    static constexpr std::size_t MaxDfaStates = 2048;
+    static constexpr int MatchNode = 0;
+
+    std::string pattern_;
+    std::vector<AstNode> ast_;
+    std::vector<ByteSet> sets_;
+    std::vector<NfaNode> nfa_;
+    int nfa_start_ = MatchNode;
+    bool has_begin_anchor_ = false;
+
+    // DFA: таблица переходов states x classes
+    bool dfa_ready_ = false;
+    std::uint8_t byte_class_[256] = {};
+    std::size_t class_count_ = 0;
+    std::vector<int> table_;
+    std::vector<std::uint8_t> accepting_;        // в состоянии есть MATCH
+    std::vector<std::uint8_t> accepting_at_end_; // совпадение при конце текста
+    std::vector<std::uint8_t> dead_;             // совпадение уже невозможно
+    int dfa_begin_ = 0;
+    int dfa_restart_ = 0; // состояние "ничего не начато"
+
+    // Префильтр: обязательный литеральный префикс или байты, на которых
+    // состояние dfa_restart_ переходит само в себя
+    std::string literal_prefix_;
+    bool restart_loop_[256] = {};
+
+    // ---------- разбор шаблона ----------
+
+    class Parser {
+    private:
+        const std::string& p_;
+        std::size_t pos_ = 0;
+        CompiledRegex& re_;
+
+        [[noreturn]] void fail(const std::string& message) const {
+            throw std::invalid_argument("regex \"" + p_ + "\": " + message +
+                                        " at position " + std::to_string(pos_));
+        }
+
+        bool done() const {
+            return pos_ >= p_.size();
+        }
+
+        int add(AstNode node) {
+            re_.ast_.push_back(std::move(node));
+            return static_cast<int>(re_.ast_.size() - 1);
+        }
+
+        int addSet(const ByteSet& set) {
+            re_.sets_.push_back(set);
+            AstNode node;
+            node.kind = AstNode::Kind::SET;
+            node.set = static_cast<int>(re_.sets_.size() - 1);
+            return add(node);
+        }
+
+        static ByteSet rangeSet(unsigned char from, unsigned char to) {
+            ByteSet set;
+            for (unsigned c = from; c <= to; ++c) {
+                set.set(c);
+            }
+            return set;
+        }
+
+        static ByteSet wordSet() {
+            ByteSet set = rangeSet('a', 'z') | rangeSet('A', 'Z') | rangeSet('0', '9');
+            set.set('_');
+            return set;
+        }
+
+        static ByteSet spaceSet() {
+            ByteSet set;
+            for (char c : std::string(" \t\n\r\f\v")) {
+                set.set(static_cast<unsigned char>(c));
+            }
+            return set;
+        }
+
+        // Разбирает символ после '\'. Возвращает true и заполняет single,
+        // если это одиночный символ, иначе заполняет set классом (\d, \w, ...)
+        bool parseEscape(ByteSet& set, unsigned char& single) {
+            if (done()) {
+                fail("trailing backslash");
+            }
+            char c = p_[pos_++];
+            switch (c) {
+                case 'd': set = rangeSet('0', '9'); return false;
+                case 'D': set = ~rangeSet('0', '9'); return false;
+                case 'w': set = wordSet(); return false;
+                case 'W': set = ~wordSet(); return false;
+                case 's': set = spaceSet(); return false;
+                case 'S': set = ~spaceSet(); return false;
+                case 'n': single = '\n'; return true;
+                case 'r': single = '\r'; return true;
+                case 't': single = '\t'; return true;
+                case 'f': single = '\f'; return true;
+                case 'v': single = '\v'; return true;
+                case '0': single = '\0'; return true;
+                default:
+                    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '1' && c <= '9')) {
+                        fail(std::string("unsupported escape \\") + c);
+                    }
+                    single = static_cast<unsigned char>(c);
+                    return true;
+            }
+        }
+
+        int parseClass() {
+            ByteSet set;
+            bool negate = false;
+            if (!done() && p_[pos_] == '^') {
+                negate = true;
+                ++pos_;
+            }
+            // Как в ECMAScript: "[]" - пустой класс, "[^]" - любой байт
+            for (;;) {
+                if (done()) {
+                    fail("unterminated character class");
+                }
+                if (p_[pos_] == ']') {
+                    ++pos_;
+                    break;
+                }
+
+                ByteSet escaped;
+                unsigned char low = 0;
+                bool is_single = true;
+                if (p_[pos_] == '\\') {
+                    ++pos_;
+                    is_single = parseEscape(escaped, low);
+                } else {
+                    low = static_cast<unsigned char>(p_[pos_++]);
+                }
+                if (!is_single) {
+                    set |= escaped;
+                    continue;
+                }
+
+                if (pos_ + 1 < p_.size() && p_[pos_] == '-' && p_[pos_ + 1] != ']') {
+                    ++pos_;
+                    unsigned char high = 0;
+                    if (p_[pos_] == '\\') {
+                        ++pos_;
+                        if (!parseEscape(escaped, high)) {
+                            fail("class escape cannot end a range");
+                        }
+                    } else {
+                        high = static_cast<unsigned char>(p_[pos_++]);
+                    }
+                    if (high < low) {
+                        fail("invalid range in character class");
+                    }
+                    set |= rangeSet(low, high);
+                } else {
+                    set.set(low);
+                }
+            }
+            return addSet(negate ? ~set : set);
+        }
+
+        bool parseBraces(int& min, int& max) {
+            std::size_t saved = pos_;
+            auto readNumber = [this](int& value) {
+                std::size_t start = pos_;
+                value = 0;
+                while (!done() && p_[pos_] >= '0' && p_[pos_] <= '9') {
+                    value = value * 10 + (p_[pos_] - '0');
+                    if (value > MaxRepeat) {
+                        fail("repetition count is too large");
+                    }
+                    ++pos_;
+                }
+                return pos_ > start;
+            };
+
+            ++pos_; // '{'
+            if (!readNumber(min)) {
+                pos_ = saved;
+                return false;
+            }
+            max = min;
+            if (!done() && p_[pos_] == ',') {
+                ++pos_;
+                if (!readNumber(max)) {
+                    max = -1;
+                }
+            }
+            if (done() || p_[pos_] != '}') {
+                pos_ = saved;
+                return false;
+            }
+            ++pos_;
+            if (max >= 0 && max < min) {
+                fail("invalid repetition range");
+            }
+            return true;
+        }
+
+        int parseAtom() {
+            char c = p_[pos_++];
+            switch (c) {
+                case '(': {
+                    if (!done() && p_[pos_] == '?') {
+                        if (pos_ + 1 < p_.size() && p_[pos_ + 1] == ':') {
+                            pos_ += 2;
+                        } else {
+                            fail("unsupported group syntax");
+                        }
+                    }
+                    int inner = parseAlternation();
+                    if (done() || p_[pos_] != ')') {
+                        fail("missing ')'");
+                    }
+                    ++pos_;
+                    return inner;
+                }
+                case '[':
+                    return parseClass();
+                case '.': {
+                    ByteSet set;
+                    set.set();
+                    set.reset('\n');
+                    set.reset('\r');
+                    return addSet(set);
+                }
+                case '^': {
+                    AstNode node;
+                    node.kind = AstNode::Kind::BEGIN;
+                    return add(node);
+                }
+                case '$': {
+                    AstNode node;
+                    node.kind = AstNode::Kind::END;
+                    return add(node);
+                }
+                case '\\': {
+                    ByteSet set;
+                    unsigned char single = 0;
+                    if (parseEscape(set, single)) {
+                        set.reset();
+                        set.set(single);
+                    }
+                    return addSet(set);
+                }
+                case '*':
+                case '+':
+                case '?':
+                    --pos_;
+                    fail("nothing to repeat");
+                default: {
+                    ByteSet set;
+                    set.set(static_cast<unsigned char>(c));
+                    return addSet(set);
+                }
+            }
+        }
+
+        int parseRepeat() {
+            int atom = parseAtom();
+            while (!done()) {
+                int min = 0;
+                int max = 0;
+                char c = p_[pos_];
+                if (c == '*') {
+                    min = 0; max = -1; ++pos_;
+                } else if (c == '+') {
+                    min = 1; max = -1; ++pos_;
+                } else if (c == '?') {
+                    min = 0; max = 1; ++pos_;
+                } else if (c == '{' && parseBraces(min, max)) {
+                    // границы уже прочитаны
+                } else {
+                    break;
+                }
+                // Ленивость не влияет на то, найдётся ли совпадение
+                if (!done() && p_[pos_] == '?') {
+                    ++pos_;
+                }
+                AstNode node;
+                node.kind = AstNode::Kind::REPEAT;
+                node.min = min;
+                node.max = max;
+                node.children.push_back(atom);
+                atom = add(node);
+            }
+            return atom;
+        }
+
+        int parseConcat() {
+            std::vector<int> items;
+            while (!done() && p_[pos_] != '|' && p_[pos_] != ')') {
+                items.push_back(parseRepeat());
+            }
+            if (items.size() == 1) {
+                return items[0];
+            }
+            AstNode node;
+            node.kind = items.empty() ? AstNode::Kind::EMPTY : AstNode::Kind::CONCAT;
+            node.children = std::move(items);
+            return add(node);
+        }
+
+    public:
+        Parser(const std::string& pattern, CompiledRegex& re) : p_(pattern), re_(re) {}
+
+        int parseAlternation() {
+            std::vector<int> branches{parseConcat()};
+            while (!done() && p_[pos_] == '|') {
+                ++pos_;
+                branches.push_back(parseConcat());
+            }
+            if (branches.size() == 1) {
+                return branches[0];
+            }
+            AstNode node;
+            node.kind = AstNode::Kind::ALTERNATION;
+            node.children = std::move(branches);
+            return add(node);
+        }
+
+        int parse() {
+            int root = parseAlternation();
+            if (!done()) {
+                fail("unmatched ')'");
+            }
+            return root;
+        }
+    };
+
+    // ---------- построение NFA (от конца к началу) ----------
+
+    int addNfa(NfaNode::Kind kind, int out, int out1 = -1, int set = -1) {
+        if (nfa_.size() >= MaxNfaNodes) {
+            throw std::invalid_argument("regex \"" + pattern_ + "\": pattern is too large");
+        }
+        NfaNode node;
+        node.kind = kind;
+        node.out = out;
+        node.out1 = out1;
+        node.set = set;
+        nfa_.push_back(node);
+        return static_cast<int>(nfa_.size() - 1);
+    }
+
+    // Возвращает вход фрагмента, который после совпадения переходит в next
+    int compile(int id, int next) {
+        const AstNode& node = ast_[id];
+        switch (node.kind) {
+            case AstNode::Kind::EMPTY:
+                return next;
+            case AstNode::Kind::SET:
+                return addNfa(NfaNode::Kind::SET, next, -1, node.set);
+            case AstNode::Kind::BEGIN:
+                has_begin_anchor_ = true;
+                return addNfa(NfaNode::Kind::BEGIN, next);
+            case AstNode::Kind::END:
+                return addNfa(NfaNode::Kind::END, next);
+            case AstNode::Kind::CONCAT:
+                for (auto it = node.children.rbegin(); it != node.children.rend(); ++it) {
+                    next = compile(*it, next);
+                }
+                return next;
+            case AstNode::Kind::ALTERNATION: {
+                int entry = compile(node.children.back(), next);
+                for (std::size_t i = node.children.size() - 1; i-- > 0;) {
+                    int branch = compile(node.children[i], next);
+                    entry = addNfa(NfaNode::Kind::SPLIT, branch, entry);
+                }
+                return entry;
+            }
+            case AstNode::Kind::REPEAT: {
+                int child = node.children[0];
+                int entry = next;
+                if (node.max < 0) {
+                    int loop = addNfa(NfaNode::Kind::SPLIT, -1, next);
+                    int body = compile(child, loop);
+                    nfa_[loop].out = body;
+                    entry = loop;
+                } else {
+                    for (int i = node.min; i < node.max; ++i) {
+                        int body = compile(child, entry);
+                        entry = addNfa(NfaNode::Kind::SPLIT, body, entry);
+                    }
+                }
+                for (int i = 0; i < node.min; ++i) {
+                    entry = compile(child, entry);
+                }
+                return entry;
+            }
+        }
+        return next;
+    }
+
+    // Эпсилон-замыкание: оставляет узлы SET, END и MATCH
+    void closure(int start, bool at_begin, bool at_end, std::vector<int>& out,
+                 std::vector<unsigned>& marks, unsigned generation) const {
+        std::vector<int> stack{start};
+        while (!stack.empty()) {
+            int id = stack.back();
+            stack.pop_back();
+            if (id < 0 || marks[id] == generation) {
+                continue;
+            }
+            marks[id] = generation;
+            const NfaNode& node = nfa_[id];
+            switch (node.kind) {
+                case NfaNode::Kind::SET:
+                case NfaNode::Kind::MATCH:
+                    out.push_back(id);
+                    break;
+                case NfaNode::Kind::SPLIT:
+                    stack.push_back(node.out1);
+                    stack.push_back(node.out);
+                    break;
+                case NfaNode::Kind::BEGIN:
+                    if (at_begin) {
+                        stack.push_back(node.out);
+                    }
+                    break;
+                case NfaNode::Kind::END:
+                    if (at_end) {
+                        stack.push_back(node.out);
+                    } else {
+                        out.push_back(id);
+                    }
+                    break;
+            }
+        }
+    }
+
+    bool containsMatch(const std::vector<int>& states) const {
+        return std::find(states.begin(), states.end(), MatchNode) != states.end();
+    }
+
+    bool matchesAtEnd(const std::vector<int>& states, bool at_begin) const {
+        std::vector<unsigned> marks(nfa_.size(), 0);
+        std::vector<int> reached;
+        for (int id : states) {
+            if (nfa_[id].kind == NfaNode::Kind::END) {
+                closure(id, at_begin, true, reached, marks, 1);
+            }
+        }
+        return containsMatch(states) || containsMatch(reached);
+    }
+
+    // Следующее множество состояний после байта byte (без перезапуска)
+    void step(const std::vector<int>& states, unsigned char byte, std::vector<int>& next,
+              std::vector<unsigned>& marks, unsigned generation) const {
+        for (int id : states) {
+            const NfaNode& node = nfa_[id];
+            if (node.kind == NfaNode::Kind::SET && sets_[node.set][byte]) {
+                closure(node.out, false, false, next, marks, generation);
+            }
+        }
+    }
+
+    void buildByteClasses() {
+        std::map<std::vector<bool>, std::uint8_t> classes;
+        for (unsigned b = 0; b < 256; ++b) {
+            std::vector<bool> signature(sets_.size());
+            for (std::size_t i = 0; i < sets_.size(); ++i) {
+                signature[i] = sets_[i][b];
+            }
+            auto it = classes.emplace(signature, static_cast<std::uint8_t>(classes.size())).first;
+            byte_class_[b] = it->second;
+        }
+        class_count_ = classes.size();
+    }
+
+    void buildDfa() {
+        using Key = std::pair<bool, std::vector<int>>;
+        std::map<Key, int> ids;
+        std::vector<Key> states;
+        std::vector<unsigned> marks(nfa_.size(), 0);
+        unsigned generation = 0;
+
+        auto intern = [&](Key key) {
+            std::sort(key.second.begin(), key.second.end());
+            key.second.erase(std::unique(key.second.begin(), key.second.end()), key.second.end());
+            auto found = ids.find(key);
+            if (found != ids.end()) {
+                return found->second;
+            }
+            int id = static_cast<int>(states.size());
+            ids.emplace(key, id);
+            states.push_back(std::move(key));
+            return id;
+        };
+
+        std::vector<int> restart;
+        closure(nfa_start_, false, false, restart, marks, ++generation);
+        std::vector<int> begin;
+        closure(nfa_start_, true, false, begin, marks, ++generation);
+
+        dfa_begin_ = intern(Key{has_begin_anchor_, begin});
+        dfa_restart_ = intern(Key{false, restart});
+
+        std::vector<int> next;
+        for (std::size_t current = 0; current < states.size(); ++current) {
+            if (states.size() > MaxDfaStates) {
+                table_.clear(); // остаёмся на симуляции NFA
+                return;
+            }
+            table_.resize((current + 1) * class_count_, -1);
+            for (unsigned b = 0; b < 256; ++b) {
+                int& target = table_[current * class_count_ + byte_class_[b]];
+                if (target >= 0) {
+                    continue;
+                }
+                next = restart;
+                ++generation;
+                for (int id : restart) {
+                    marks[id] = generation;
+                }
+                step(states[current].second, static_cast<unsigned char>(b), next, marks, generation);
+                int id = intern(Key{false, next});
+                // intern мог увеличить states, но не table_
+                table_[current * class_count_ + byte_class_[b]] = id;
+            }
+        }
+
+        for (const Key& key : states) {
+            bool accepting = containsMatch(key.second);
+            accepting_.push_back(accepting);
+            accepting_at_end_.push_back(matchesAtEnd(key.second, key.first));
+            dead_.push_back(key.second.empty());
+        }
+        for (unsigned b = 0; b < 256; ++b) {
+            restart_loop_[b] = table_[dfa_restart_ * class_count_ + byte_class_[b]] == dfa_restart_;
+        }
+        dfa_ready_ = true;
+    }
+
+    // Литеральный префикс, с которого обязано начинаться любое совпадение
+    void extractLiteralPrefix(int root) {
+        auto singleByte = [this](int id, unsigned char& byte) {
+            const AstNode& node = ast_[id];
+            if (node.kind != AstNode::Kind::SET || sets_[node.set].count() != 1) {
+                return false;
+            }
+            for (unsigned b = 0; b < 256; ++b) {
+                if (sets_[node.set][b]) {
+                    byte = static_cast<unsigned char>(b);
+                }
+            }
+            return true;
+        };
+
+        std::vector<int> items;
+        if (ast_[root].kind == AstNode::Kind::CONCAT) {
+            items = ast_[root].children;
+        } else {
+            items.push_back(root);
+        }
+        unsigned char byte = 0;
+        for (int id : items) {
+            if (!singleByte(id, byte)) {
+                break;
+            }
+            literal_prefix_ += static_cast<char>(byte);
+        }
+    }
+
+    bool searchDfa(std::string_view text) const {
+        int state = dfa_begin_;
+        if (accepting_[state]) {
+            return true;
+        }
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+        std::size_t size = text.size();
+        for (std::size_t i = 0; i < size; ++i) {
+            if (state == dfa_restart_) {
+                if (!literal_prefix_.empty()) {
+                    std::size_t found = text.find(literal_prefix_, i);
+                    if (found == std::string_view::npos) {
+                        return false;
+                    }
+                    i = found;
+                } else {
+                    while (i < size && restart_loop_[data[i]]) {
+                        ++i;
+                    }
+                    if (i == size) {
+                        break;
+                    }
+                }
+            }
+            state = table_[state * class_count_ + byte_class_[data[i]]];
+            if (accepting_[state]) {
+                return true;
+            }
+            if (dead_[state]) {
+                return false;
+            }
+        }
+        return accepting_at_end_[state];
+    }
+
+    bool searchNfa(std::string_view text) const {
+        std::vector<unsigned> marks(nfa_.size(), 0);
+        unsigned generation = 0;
+        std::vector<int> current;
+        std::vector<int> next;
+        closure(nfa_start_, true, false, current, marks, ++generation);
+        for (char c : text) {
+            if (containsMatch(current)) {
+                return true;
+            }
+            next.clear();
+            ++generation;
+            step(current, static_cast<unsigned char>(c), next, marks, generation);
+            closure(nfa_start_, false, false, next, marks, generation);
+            current.swap(next);
+        }
+        return matchesAtEnd(current, text.empty());
+    }
+
+public:
+    explicit CompiledRegex(const std::string& pattern) : pattern_(pattern) {
+        Parser parser(pattern_, *this);
+        int root = parser.parse();
+
+        nfa_.push_back(NfaNode{}); // MatchNode
+        nfa_start_ = compile(root, MatchNode);
+
+        buildByteClasses();
+        extractLiteralPrefix(root);
+        buildDfa();
+    }
+
+    const std::string& pattern() const {
+        return pattern_;
+    }
+
+    // Есть ли в тексте подстрока, удовлетворяющая шаблону (аналог std::regex_search)
+    bool search(std::string_view text) const {
+        return dfa_ready_ ? searchDfa(text) : searchNfa(text);
+    }
+};
@@ -0,0 +1,547 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// Минимальный FTP-клиент для выгрузки файлов (RFC 959, пассивный режим).
+// Все операции блокирующие, с таймаутом на каждую операцию сокета;
+// abort() из другого потока прерывает их сразу
+class FtpClient {
+private:
+    int control_ = -1;
+    std::string buffered_; // прочитанные, но ещё не разобранные ответы
+    std::chrono::seconds timeout_;
+
+    std::mutex sockets_mutex_;
+    std::vector<int> sockets_; // открытые сокеты, которые прерывает abort()
+    bool aborted_ = false;
+
+    bool track(int fd) {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        if (aborted_) {
+            return false;
+        }
+        sockets_.push_back(fd);
+        return true;
+    }
+
+    // Сокет убирается из списка до close, чтобы abort() не задел чужой
+    // дескриптор с тем же номером
+    void closeSocket(int fd) {
+        {
+            std::lock_guard<std::mutex> lock(sockets_mutex_);
+            sockets_.erase(std::remove(sockets_.begin(), sockets_.end(), fd), sockets_.end());
+        }
+        ::close(fd);
+    }
+
+    int connectTo(const std::string& host, const std::string& port) {
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* result = nullptr;
+        if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+            return -1;
+        }
+        int connected = -1;
+        timeval tv{static_cast<time_t>(timeout_.count()), 0};
+        for (addrinfo* ai = result; ai != nullptr && connected < 0; ai = ai->ai_next) {
+            int fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            if (!track(fd)) {
+                ::close(fd);
+                break;
+            }
+            // В Linux SO_SNDTIMEO ограничивает и connect
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+            if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                connected = fd;
+            } else {
+                closeSocket(fd);
+            }
+        }
+        ::freeaddrinfo(result);
+        return connected;
+    }
+
+    static bool sendAll(int fd, const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    bool readLine(std::string& line) {
+        for (;;) {
+            std::size_t end = buffered_.find("\r\n");
+            if (end != std::string::npos) {
+                line = buffered_.substr(0, end);
+                buffered_.erase(0, end + 2);
+                return true;
+            }
+            char chunk[512];
+            ssize_t received = ::recv(control_, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                if (received < 0 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            buffered_.append(chunk, static_cast<std::size_t>(received));
+        }
+    }
+
+public:
+    explicit FtpClient(std::chrono::seconds timeout = std::chrono::seconds(10)) : timeout_(timeout) {}
+
+    FtpClient(const FtpClient&) = delete;
+    FtpClient& operator=(const FtpClient&) = delete;
+
+    ~FtpClient() {
+        if (control_ >= 0) {
+            command("QUIT");
+            closeSocket(control_);
+        }
+    }
+
+    // Прерывает текущую и все последующие операции (из любого потока)
+    void abort() {
+        std::lock_guard<std::mutex> lock(sockets_mutex_);
+        aborted_ = true;
+        for (int fd : sockets_) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    // Читает ответ сервера (в том числе многострочный); возвращает код или -1
+    int readReply(std::string* text = nullptr) {
+        std::string line;
+        if (!readLine(line) || line.size() < 3) {
+            return -1;
+        }
+        std::string code = line.substr(0, 3);
+        if (line.size() > 3 && line[3] == '-') {
+            // Многострочный ответ заканчивается строкой "ddd "
+            std::string next;
+            do {
+                if (!readLine(next)) {
+                    return -1;
+                }
+            } while (next.compare(0, 4, code + " ") != 0);
+        }
+        if (text != nullptr) {
+            *text = line;
+        }
+        return std::atoi(code.c_str());
+    }
+
+    int command(const std::string& line, std::string* reply = nullptr) {
+        std::string request = line + "\r\n";
+        if (!sendAll(control_, request.data(), request.size())) {
+            return -1;
+        }
+        return readReply(reply);
+    }
+
+    bool login(const std::string& host, const std::string& port,
+               const std::string& user, const std::string& password) {
+        control_ = connectTo(host, port);
+        if (control_ < 0 || readReply() != 220) {
+            return false;
+        }
+        int code = command("USER " + user);
+        if (code == 331) {
+            code = command("PASS " + password);
+        }
+        return code == 230 && command("TYPE I") == 200;
+    }
+
+    // Размер файла на сервере; -1 - файла нет
+    long long remoteSize(const std::string& path) {
+        std::string reply;
+        if (command("SIZE " + path, &reply) != 213 || reply.size() < 5) {
+            return -1;
+        }
+        return std::atoll(reply.c_str() + 4);
+    }
+
+    // Открывает соединение данных (PASV) и отправляет команду передачи
+    int openData(const std::string& line) {
+        std::string reply;
+        if (command("PASV", &reply) != 227) {
+            return -1;
+        }
+        std::size_t open = reply.find('(');
+        unsigned h1, h2, h3, h4, p1, p2;
+        if (open == std::string::npos ||
+            std::sscanf(reply.c_str() + open + 1, "%u,%u,%u,%u,%u,%u", &h1, &h2, &h3, &h4, &p1, &p2) != 6) {
+            return -1;
+        }
+        // Адрес из ответа часто неверен за NAT - подключаемся к тому же хосту,
+        // что и управляющее соединение
+        sockaddr_storage peer{};
+        socklen_t peer_length = sizeof(peer);
+        char host[NI_MAXHOST];
+        if (::getpeername(control_, reinterpret_cast<sockaddr*>(&peer), &peer_length) != 0 ||
+            ::getnameinfo(reinterpret_cast<sockaddr*>(&peer), peer_length, host, sizeof(host),
+                          nullptr, 0, NI_NUMERICHOST) != 0) {
+            return -1;
+        }
+        int data = connectTo(host, std::to_string(p1 * 256 + p2));
+        if (data < 0) {
+            return -1;
+        }
+        int code = command(line);
+        if (code != 125 && code != 150) {
+            closeSocket(data);
+            return -1;
+        }
+        return data;
+    }
+
+    // Дописывает файл на сервере с позиции offset локального файла (APPE)
+    bool append(const std::string& remote_path, int local_fd, long long offset) {
+        int data = openData("APPE " + remote_path);
+        if (data < 0) {
+            return false;
+        }
+        std::vector<char> chunk(64 * 1024);
+        bool ok = true;
+        for (;;) {
+            ssize_t got = ::pread(local_fd, chunk.data(), chunk.size(), static_cast<off_t>(offset));
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                ok = got == 0;
+                break;
+            }
+            if (!sendAll(data, chunk.data(), static_cast<std::size_t>(got))) {
+                ok = false;
+                break;
+            }
+            offset += got;
+        }
+        closeSocket(data);
+        int code = readReply();
+        return ok && code == 226;
+    }
+
+    bool rename(const std::string& from, const std::string& to) {
+        return command("RNFR " + from) == 350 && command("RNTO " + to) == 250;
+    }
+};
+
+// Выгрузка закрытых файлов-сегментов в фоновом потоке.
+// Цель - FTP-сервер ("host" или "host:port") или, для проверки без сервера,
+// каталог ("file://<каталог>"); в обоих случаях файлы кладутся в remote_dir.
+// Файл сначала дописывается в <имя>.part с той позиции, на которой
+// остановилась прошлая попытка, а после полной передачи переименовывается,
+// поэтому получатель никогда не видит недописанный сегмент.
+// Успешно выгруженный локальный файл удаляется; при ошибке выгрузка
+// повторяется с экспоненциальной задержкой, порядок файлов сохраняется.
+// В очереди не больше max_pending файлов: при переполнении (сервер долго
+// недоступен) самый старый ожидающий файл удаляется, чтобы каталог не рос
+// без предела.
+class SegmentUploader {
+private:
+    std::string server_;
+    std::string remote_dir_;
+    std::string user_;
+    std::string password_;
+    std::string name_prefix_; // "<hostname>-", чтобы не смешивать файлы разных машин
+    std::chrono::milliseconds tick_interval_;
+    std::function<void()> on_tick_;
+    std::size_t max_pending_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::deque<std::string> queue_;
+    bool uploading_front_ = false; // queue_.front() сейчас выгружается
+    FtpClient* active_client_ = nullptr; // прерывается при остановке
+    bool stopping_ = false;
+    std::thread worker_;
+
+    std::atomic<std::size_t> uploaded_{0};
+    std::atomic<std::size_t> failures_{0};
+    std::atomic<unsigned long long> bytes_uploaded_{0};
+    std::atomic<std::size_t> discarded_{0};
+    bool last_attempt_ok_; // только в фоновом потоке
+
+    static constexpr std::chrono::seconds MinRetryDelay{1};
+    static constexpr std::chrono::seconds MaxRetryDelay{60};
+    static constexpr std::chrono::seconds ShutdownBudget{3};
+    static constexpr std::chrono::seconds OperationTimeout{10};
+
+    bool directoryMode() const {
+        return server_.compare(0, 7, "file://") == 0;
+    }
+
+    std::string remoteName(const std::string& local_path) const {
+        return name_prefix_ + std::filesystem::path(local_path).filename().string();
+    }
+
+    bool uploadToDirectory(const std::string& local_path) {
+        std::filesystem::path directory = std::filesystem::path(server_.substr(7)) /
+                                          std::filesystem::path(remote_dir_).relative_path();
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        std::filesystem::path target = directory / remoteName(local_path);
+        std::string part = target.string() + ".part";
+
+        int in = ::open(local_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            return false;
+        }
+        int out = ::open(part.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (out < 0) {
+            ::close(in);
+            return false;
+        }
+        // Продолжаем с места, где остановилась прошлая попытка
+        off_t offset = ::lseek(out, 0, SEEK_END);
+        std::vector<char> chunk(64 * 1024);
+        bool ok = offset >= 0;
+        while (ok) {
+            ssize_t got = ::pread(in, chunk.data(), chunk.size(), offset);
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            if (got <= 0) {
+                ok = got == 0;
+                break;
+            }
+            if (::write(out, chunk.data(), static_cast<std::size_t>(got)) != got) {
+                ok = false;
+                break;
+            }
+            // Считаем только байты, которые действительно записаны
+            offset += got;
+            bytes_uploaded_.fetch_add(static_cast<unsigned long long>(got), std::memory_order_relaxed);
+        }
+        ok = ok && ::fsync(out) == 0;
+        ::close(out);
+        ::close(in);
+        return ok && ::rename(part.c_str(), target.c_str()) == 0;
+    }
+
+    bool uploadToFtp(const std::string& local_path, std::chrono::seconds timeout) {
+        std::string host = server_;
+        std::string port = "21";
+        std::size_t colon = server_.rfind(':');
+        if (colon != std::string::npos && server_.find(':') == colon) {
+            host = server_.substr(0, colon);
+            port = server_.substr(colon + 1);
+        }
+        std::string directory = remote_dir_;
+        if (!directory.empty() && directory.back() != '/') {
+            directory += '/';
+        }
+        std::string target = directory + remoteName(local_path);
+        std::string part = target + ".part";
+
+        int in = ::open(local_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            return false;
+        }
+        FtpClient client(timeout);
+        {
+            // Попытку из основного цикла прерывает остановка (см. деструктор)
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_client_ = &client;
+            if (stopping_ && uploading_front_) {
+                client.abort();
+            }
+        }
+        bool ok = client.login(host, port, user_, password_);
+        if (ok) {
+            long long offset = std::max(0LL, client.remoteSize(part));
+            off_t local_size = ::lseek(in, 0, SEEK_END);
+            ok = offset <= local_size &&
+                 (offset == local_size || client.append(part, in, offset)) &&
+                 client.rename(part, target);
+            if (ok) {
+                bytes_uploaded_.fetch_add(static_cast<unsigned long long>(local_size - offset),
+                                          std::memory_order_relaxed);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_client_ = nullptr;
+        }
+        ::close(in);
+        return ok;
+    }
+
+    bool upload(const std::string& local_path, std::chrono::seconds timeout = OperationTimeout) {
+        if (::access(local_path.c_str(), F_OK) != 0) {
+            return true; // файла уже нет - выгружать нечего
+        }
+        bool ok = directoryMode() ? uploadToDirectory(local_path) : uploadToFtp(local_path, timeout);
+        if (ok) {
+            std::remove(local_path.c_str());
+            uploaded_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        last_attempt_ok_ = ok;
+        return ok;
+    }
+
+    void workerLoop() {
+        auto retry_delay = std::chrono::seconds(0);
+        auto next_attempt = std::chrono::steady_clock::now();
+        auto next_tick = std::chrono::steady_clock::now() + tick_interval_;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= next_tick) {
+                next_tick = now + tick_interval_;
+                if (on_tick_) {
+                    lock.unlock();
+                    on_tick_(); // может добавить сегмент в очередь через submit
+                    lock.lock();
+                    continue;
+                }
+            }
+            if (queue_.empty() || now < next_attempt) {
+                auto until = queue_.empty() ? next_tick : std::min(next_tick, next_attempt);
+                wakeup_.wait_until(lock, until);
+                continue;
+            }
+            std::string path = queue_.front();
+            uploading_front_ = true;
+            lock.unlock();
+            bool ok = upload(path);
+            lock.lock();
+            uploading_front_ = false;
+            if (ok) {
+                queue_.pop_front();
+                retry_delay = std::chrono::seconds(0);
+            } else {
+                retry_delay = std::min<std::chrono::seconds>(
+                    MaxRetryDelay, retry_delay.count() == 0 ? MinRetryDelay : retry_delay * 2);
+                next_attempt = std::chrono::steady_clock::now() + retry_delay;
+            }
+        }
+        // При остановке остаток выгружается, только если последняя попытка
+        // удалась (сервер ни разу не отвечал - не пытаемся), и на FTP - не
+        // дольше ShutdownBudget в сумме. Остальные файлы остаются в каталоге
+        // и будут выгружены при следующем запуске
+        auto deadline = std::chrono::steady_clock::now() + ShutdownBudget;
+        while (!queue_.empty() && last_attempt_ok_) {
+            auto left = std::chrono::duration_cast<std::chrono::seconds>(deadline - std::chrono::steady_clock::now());
+            if (!directoryMode() && left.count() < 1) {
+                break;
+            }
+            std::string path = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            upload(path, left);
+            lock.lock();
+        }
+    }
+
+public:
+    // on_tick вызывается из фонового потока каждые tick_interval
+    // (FtpHandler закрывает по нему текущий сегмент)
+    SegmentUploader(const std::string& server, const std::string& remote_dir,
+                    const std::string& user = "anonymous", const std::string& password = "logger@",
+                    std::chrono::milliseconds tick_interval = std::chrono::seconds(60),
+                    std::function<void()> on_tick = nullptr,
+                    std::size_t max_pending = 64)
+        : server_(server), remote_dir_(remote_dir), user_(user), password_(password),
+          tick_interval_(tick_interval), on_tick_(std::move(on_tick)),
+          max_pending_(max_pending > 0 ? max_pending : 1), last_attempt_ok_(directoryMode()) {
+        char host[256] = {};
+        ::gethostname(host, sizeof(host) - 1);
+        name_prefix_ = std::string(host) + "-";
+        worker_ = std::thread(&SegmentUploader::workerLoop, this);
+    }
+
+    SegmentUploader(const SegmentUploader&) = delete;
+    SegmentUploader& operator=(const SegmentUploader&) = delete;
+
+    ~SegmentUploader() {
+        {
+            // Попытка, начатая до остановки, может висеть до таймаута на
+            // недоступном сервере - прерываем её, файл останется в каталоге
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+            if (active_client_ != nullptr && uploading_front_) {
+                active_client_->abort();
+            }
+        }
+        wakeup_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    void submit(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(path);
+            // Выгружаемый сейчас файл не трогаем, удаляем следующий за ним
+            std::size_t oldest = uploading_front_ ? 1 : 0;
+            while (queue_.size() > max_pending_ && oldest < queue_.size() - 1) {
+                std::remove(queue_[oldest].c_str());
+                queue_.erase(queue_.begin() + static_cast<std::ptrdiff_t>(oldest));
+                discarded_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        wakeup_.notify_one();
+    }
+
+    std::size_t uploadedCount() const {
+        return uploaded_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t failureCount() const {
+        return failures_.load(std::memory_order_relaxed);
+    }
+
+    // Файлы, удалённые без выгрузки из-за переполнения очереди
+    std::size_t discardedCount() const {
+        return discarded_.load(std::memory_order_relaxed);
+    }
+
+    unsigned long long bytesUploaded() const {
+        return bytes_uploaded_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t pending() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+};
@@ -0,0 +1,341 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// Транспорт для отправки логов по сети
+enum class SocketTransport {
+    UDP, // записи через '\n', несколько записей в одной датаграмме
+    TCP  // кадры [uint32 длина, big-endian][запись]
+};
+
+// Пакетная отправка записей по UDP или TCP. handle-поток только дописывает
+// запись в буфер под мьютексом; сеть обслуживает фоновый поток, который
+// отправляет буфер, когда он превысил batch_bytes или истёк flush_interval.
+// При обрыве TCP соединение восстанавливается с экспоненциальной задержкой,
+// записи копятся до max_pending_bytes, сверх этого - отбрасываются.
+// По UDP запись длиннее датаграммы обрезается (recordsTruncated), а записи
+// датаграммы, которую не удалось отправить, считаются потерянными.
+class BatchedSocketSender {
+private:
+    std::string address_;
+    int port_;
+    SocketTransport transport_;
+    std::size_t batch_bytes_;
+    std::size_t max_datagram_;
+    std::size_t max_pending_bytes_;
+    std::chrono::milliseconds flush_interval_;
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::string pending_; // кадры [uint32 длина][данные] в порядке поступления
+    bool stopping_ = false;
+    bool stopped_ = false;
+    std::size_t flush_requests_ = 0; // номер последнего запроса flush()
+    std::size_t flush_done_ = 0;     // запросы с номером <= этого обслужены
+    std::condition_variable flushed_;
+    std::thread worker_;
+
+    // Состояние соединения - только в фоновом потоке
+    int socket_ = -1;
+    std::chrono::milliseconds backoff_{0};
+    std::chrono::steady_clock::time_point next_connect_attempt_{};
+
+    std::atomic<std::size_t> records_sent_{0};
+    std::atomic<std::size_t> records_dropped_{0};
+    std::atomic<std::size_t> records_truncated_{0};
+    std::atomic<std::size_t> bytes_sent_{0};
+    std::atomic<std::size_t> reconnects_{0};
+
+    static constexpr std::chrono::milliseconds MinBackoff{100};
+    static constexpr std::chrono::milliseconds MaxBackoff{5000};
+
+    static void putLength(std::string& out, std::uint32_t length) {
+        char bytes[4] = {
+            static_cast<char>((length >> 24) & 0xFF), static_cast<char>((length >> 16) & 0xFF),
+            static_cast<char>((length >> 8) & 0xFF), static_cast<char>(length & 0xFF)
+        };
+        out.append(bytes, 4);
+    }
+
+    static std::uint32_t getLength(const char* data) {
+        const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+        return (static_cast<std::uint32_t>(bytes[0]) << 24) | (static_cast<std::uint32_t>(bytes[1]) << 16) |
+               (static_cast<std::uint32_t>(bytes[2]) << 8) | static_cast<std::uint32_t>(bytes[3]);
+    }
+
+    bool connectSocket() {
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_connect_attempt_) {
+            return false;
+        }
+        addrinfo hints{};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = transport_ == SocketTransport::TCP ? SOCK_STREAM : SOCK_DGRAM;
+        addrinfo* result = nullptr;
+        std::string port = std::to_string(port_);
+        if (::getaddrinfo(address_.c_str(), port.c_str(), &hints, &result) == 0) {
+            for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+                int fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC, ai->ai_protocol);
+                if (fd < 0) {
+                    continue;
+                }
+                if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+                    if (transport_ == SocketTransport::TCP) {
+                        int one = 1;
+                        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    }
+                    socket_ = fd;
+                    break;
+                }
+                ::close(fd);
+            }
+            ::freeaddrinfo(result);
+        }
+        if (socket_ < 0) {
+            backoff_ = std::min(MaxBackoff, backoff_.count() == 0 ? MinBackoff : backoff_ * 2);
+            next_connect_attempt_ = now + backoff_;
+            return false;
+        }
+        backoff_ = std::chrono::milliseconds(0);
+        return true;
+    }
+
+    void disconnect() {
+        if (socket_ >= 0) {
+            ::close(socket_);
+            socket_ = -1;
+            reconnects_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    bool sendAll(const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t sent = ::send(socket_, data, size, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += sent;
+            size -= static_cast<std::size_t>(sent);
+        }
+        return true;
+    }
+
+    // Отправляет batch и учитывает отправленные и потерянные записи;
+    // false - нет соединения или обрыв TCP, пакет стоит вернуть в очередь
+    bool sendBatch(const std::string& batch) {
+        if (socket_ < 0 && !connectSocket()) {
+            return false;
+        }
+        if (transport_ == SocketTransport::TCP) {
+            // Кадры уже в формате протокола; при ошибке соединение закрывается
+            // и весь пакет отправляется повторно после переподключения
+            // (получатель может увидеть начало пакета дважды)
+            if (!sendAll(batch.data(), batch.size())) {
+                disconnect();
+                return false;
+            }
+            bytes_sent_.fetch_add(batch.size(), std::memory_order_relaxed);
+            records_sent_.fetch_add(countRecords(batch), std::memory_order_relaxed);
+            return true;
+        }
+
+        // UDP: склеиваем записи в датаграммы не длиннее max_datagram_
+        std::string datagram;
+        datagram.reserve(max_datagram_);
+        std::size_t records = 0; // записей в datagram
+        std::size_t offset = 0;
+        auto sendDatagram = [this, &datagram, &records]() {
+            if (datagram.empty()) {
+                return;
+            }
+            // Ошибки UDP (например, ECONNREFUSED без получателя) не лечатся
+            // повтором: записи датаграммы теряются
+            ssize_t sent;
+            do {
+                sent = ::send(socket_, datagram.data(), datagram.size(), MSG_NOSIGNAL);
+            } while (sent < 0 && errno == EINTR);
+            if (sent == static_cast<ssize_t>(datagram.size())) {
+                bytes_sent_.fetch_add(datagram.size(), std::memory_order_relaxed);
+                records_sent_.fetch_add(records, std::memory_order_relaxed);
+            } else {
+                records_dropped_.fetch_add(records, std::memory_order_relaxed);
+            }
+            datagram.clear();
+            records = 0;
+        };
+        while (offset + 4 <= batch.size()) {
+            std::size_t length = getLength(batch.data() + offset);
+            const char* record = batch.data() + offset + 4;
+            offset += 4 + length;
+            if (length > max_datagram_ - 1) {
+                length = max_datagram_ - 1;
+                records_truncated_.fetch_add(1, std::memory_order_relaxed);
+            }
+            if (!datagram.empty() && datagram.size() + length + 1 > max_datagram_) {
+                sendDatagram();
+            }
+            datagram.append(record, length);
+            datagram += '\n';
+            ++records;
+        }
+        sendDatagram();
+        return true;
+    }
+
+    static std::size_t countRecords(const std::string& batch) {
+        std::size_t count = 0;
+        for (std::size_t offset = 0; offset + 4 <= batch.size(); offset += 4 + getLength(batch.data() + offset)) {
+            ++count;
+        }
+        return count;
+    }
+
+    void workerLoop() {
+        std::string batch;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wakeup_.wait_for(lock, flush_interval_, [this] {
+                return stopping_ || flush_requests_ != flush_done_ || pending_.size() >= batch_bytes_;
+            });
+            bool stopping = stopping_;
+            std::size_t served = flush_requests_;
+
+            bool failed = false;
+            if (!pending_.empty()) {
+                batch.swap(pending_);
+                lock.unlock();
+                failed = !sendBatch(batch);
+                lock.lock();
+                if (failed) {
+                    // Не отправили: возвращаем пакет в начало очереди, если есть место
+                    if (!stopping && batch.size() + pending_.size() <= max_pending_bytes_) {
+                        batch += pending_;
+                        pending_.swap(batch);
+                    } else {
+                        records_dropped_.fetch_add(countRecords(batch), std::memory_order_relaxed);
+                    }
+                }
+                batch.clear();
+            }
+            flush_done_ = served;
+            flushed_.notify_all();
+
+            if (stopping) {
+                // При остановке делается одна попытка; недоступный получатель не ждём
+                records_dropped_.fetch_add(countRecords(pending_), std::memory_order_relaxed);
+                pending_.clear();
+                break;
+            }
+            if (failed) {
+                // Получатель недоступен: ждём следующей попытки подключения;
+                // flush() в это время отвечает сразу, записи остаются в очереди
+                wakeup_.wait_until(lock, next_connect_attempt_, [this] {
+                    return stopping_ || flush_requests_ != flush_done_;
+                });
+            }
+        }
+        stopped_ = true;
+        flushed_.notify_all();
+        lock.unlock();
+        if (socket_ >= 0) {
+            ::close(socket_);
+            socket_ = -1;
+        }
+    }
+
+public:
+    BatchedSocketSender(const std::string& address, int port,
+                        SocketTransport transport = SocketTransport::UDP,
+                        std::size_t batch_bytes = 16 * 1024,
+                        std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100),
+                        std::size_t max_datagram = 1400,
+                        std::size_t max_pending_bytes = 4 * 1024 * 1024)
+        : address_(address), port_(port), transport_(transport), batch_bytes_(batch_bytes),
+          max_datagram_(std::max<std::size_t>(max_datagram, 64)),
+          max_pending_bytes_(max_pending_bytes), flush_interval_(flush_interval) {
+        pending_.reserve(batch_bytes_ * 2);
+        worker_ = std::thread(&BatchedSocketSender::workerLoop, this);
+    }
+
+    BatchedSocketSender(const BatchedSocketSender&) = delete;
+    BatchedSocketSender& operator=(const BatchedSocketSender&) = delete;
+
+    ~BatchedSocketSender() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    void send(const char* data, std::size_t size) {
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.size() + size + 4 > max_pending_bytes_) {
+                records_dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            putLength(pending_, static_cast<std::uint32_t>(size));
+            pending_.append(data, size);
+            wake = pending_.size() >= batch_bytes_;
+        }
+        if (wake) {
+            wakeup_.notify_one();
+        }
+    }
+
+    // Ждёт одной попытки отправить всё, что накоплено к моменту вызова
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        std::size_t ticket = ++flush_requests_;
+        wakeup_.notify_one();
+        flushed_.wait(lock, [this, ticket] { return stopped_ || flush_done_ >= ticket; });
+    }
+
+    std::size_t recordsSent() const {
+        return records_sent_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t recordsDropped() const {
+        return records_dropped_.load(std::memory_order_relaxed);
+    }
+
+    // Записи UDP, обрезанные до длины датаграммы (отправлены, но не целиком)
+    std::size_t recordsTruncated() const {
+        return records_truncated_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t bytesSent() const {
+        return bytes_sent_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t reconnects() const {
+        return reconnects_.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LOGGER_HAS_X86_SIMD 1
+#else
+#define LOGGER_HAS_X86_SIMD 0
+#endif
+
+// Реализация поиска подстроки
+enum class SearchKernel {
+    AUTO,   // лучшая из доступных на этом процессоре
+    SCALAR, // std::string_view::find
+    SSE2,
+    AVX2
+};
+
+// Поиск одной подстроки. SIMD-ядра сравнивают сразу 16/32 позиции по первому
+// и последнему байту образца и проверяют memcmp только совпавших кандидатов,
+// поэтому на обычном тексте почти все байты отсеиваются двумя сравнениями.
+// Ядро выбирается один раз в конструкторе по CPUID.
+class SubstringSearcher {
+private:
+    using Kernel = std::size_t (*)(const char*, std::size_t, const char*, std::size_t);
+
+    std::string needle_;
+    SearchKernel kind_;
+    Kernel kernel_;
+
+    static std::size_t findScalar(const char* text, std::size_t size,
+                                  const char* needle, std::size_t length) {
+        return std::string_view(text, size).find(std::string_view(needle, length));
+    }
+
+#if LOGGER_HAS_X86_SIMD
+    // Проверка кандидатов из битовой маски; возвращает смещение или npos
+    static std::size_t checkCandidates(unsigned mask, const char* block,
+                                       const char* needle, std::size_t length) {
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (std::memcmp(block + bit + 1, needle + 1, length - 2) == 0) {
+                return bit;
+            }
+            mask &= mask - 1;
+        }
+        return std::string_view::npos;
+    }
+
+    __attribute__((target("sse2")))
+    static std::size_t findSse2(const char* text, std::size_t size,
+                                const char* needle, std::size_t length) {
+        if (length < 2 || length > size) {
+            return findScalar(text, size, needle, length);
+        }
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last = _mm_set1_epi8(needle[length - 1]);
+        std::size_t i = 0;
+        for (; i + length - 1 + 16 <= size; i += 16) {
+            __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+            __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + length - 1));
+            __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                                       _mm_cmpeq_epi8(last, block_last));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+            std::size_t found = checkCandidates(mask, text + i, needle, length);
+            if (found != std::string_view::npos) {
+                return i + found;
+            }
+        }
+        std::size_t tail = findScalar(text + i, size - i, needle, length);
+        return tail == std::string_view::npos ? tail : i + tail;
+    }
+
+    __attribute__((target("avx2")))
+    static std::size_t findAvx2(const char* text, std::size_t size,
+                                const char* needle, std::size_t length) {
+        if (length < 2 || length > size) {
+            return findScalar(text, size, needle, length);
+        }
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last = _mm256_set1_epi8(needle[length - 1]);
+        std::size_t i = 0;
+        for (; i + length - 1 + 32 <= size; i += 32) {
+            __m256i block_first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i));
+            __m256i block_last = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + i + length - 1));
+            __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                                          _mm256_cmpeq_epi8(last, block_last));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+            std::size_t found = checkCandidates(mask, text + i, needle, length);
+            if (found != std::string_view::npos) {
+                return i + found;
+            }
+        }
+        // Хвост короче 32 байт досматриваем SSE2-ядром
+        std::size_t tail = findSse2(text + i, size - i, needle, length);
+        return tail == std::string_view::npos ? tail : i + tail;
+    }
+#endif
+
+    static Kernel kernelFor(SearchKernel kind) {
+        switch (kind) {
+#if LOGGER_HAS_X86_SIMD
+            case SearchKernel::SSE2: return &findSse2;
+            case SearchKernel::AVX2: return &findAvx2;
+#endif
+            default: return &findScalar;
+        }
+    }
+
+public:
+    // Лучшее ядро для текущего процессора
+    static SearchKernel bestKernel() {
+#if LOGGER_HAS_X86_SIMD
+        static const SearchKernel best = [] {
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return SearchKernel::AVX2;
+            }
+            if (__builtin_cpu_supports("sse2")) {
+                return SearchKernel::SSE2;
+            }
+            return SearchKernel::SCALAR;
+        }();
+        return best;
+#else
+        return SearchKernel::SCALAR;
+#endif
+    }
+
+    static bool isSupported(SearchKernel kind) {
+        switch (kind) {
+            case SearchKernel::AUTO:
+            case SearchKernel::SCALAR:
+                return true;
+            case SearchKernel::SSE2:
+                return bestKernel() == SearchKernel::SSE2 || bestKernel() == SearchKernel::AVX2;
+            case SearchKernel::AVX2:
+                return bestKernel() == SearchKernel::AVX2;
+        }
+        return false;
+    }
+
+    // Неподдерживаемое процессором ядро заменяется на лучшее доступное
+    explicit SubstringSearcher(std::string needle, SearchKernel kind = SearchKernel::AUTO)
+        : needle_(std::move(needle)),
+          kind_(kind == SearchKernel::AUTO || !isSupported(kind) ? bestKernel() : kind),
+          kernel_(kernelFor(kind_)) {}
+
+    // Позиция первого вхождения или std::string_view::npos
+    std::size_t find(std::string_view text) const {
+        return kernel_(text.data(), text.size(), needle_.data(), needle_.size());
+    }
+
+    bool contains(std::string_view text) const {
+        return find(text) != std::string_view::npos;
+    }
+
+    const std::string& needle() const {
+        return needle_;
+    }
+
+    SearchKernel kernel() const {
+        return kind_;
+    }
+};
@@ -0,0 +1,306 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Важность по RFC 5424 (значения совпадают с LOG_* из <syslog.h>)
+enum class SyslogSeverity {
+    EMERGENCY = 0, ALERT = 1, CRITICAL = 2, ERROR = 3,
+    WARNING = 4, NOTICE = 5, INFORMATIONAL = 6, DEBUG = 7
+};
+
+// Отправка кадров RFC 5424 в локальный syslog через Unix datagram сокет.
+// Неизменная часть заголовка (HOSTNAME APP-NAME PROCID MSGID SD) собирается
+// один раз в конструкторе, для каждой записи дописываются только PRI и время.
+// Записи копятся в буфере и уходят фоновым потоком пачками по одному
+// вызову sendmmsg. Если сокет недоступен, записи копятся до max_pending,
+// сверх этого - отбрасываются.
+class SyslogSender {
+private:
+    std::string path_;
+    int facility_;
+    std::size_t batch_size_;
+    std::size_t max_pending_;
+    std::size_t max_message_;
+    std::chrono::milliseconds flush_interval_;
+    std::string header_tail_; // " HOSTNAME APP-NAME PROCID - - "
+
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::vector<std::string> pending_;
+    bool stopping_ = false;
+    bool stopped_ = false;
+    std::size_t flush_requests_ = 0;
+    std::size_t flush_done_ = 0;
+    std::condition_variable flushed_;
+    std::thread worker_;
+
+    // Только в фоновом потоке
+    int socket_ = -1;
+    std::chrono::steady_clock::time_point next_connect_attempt_{};
+
+    // Под mutex_
+    std::time_t cached_second_ = -1;
+    char cached_prefix_[32] = {}; // "YYYY-MM-DDTHH:MM:SS"
+
+    std::atomic<std::size_t> records_sent_{0};
+    std::atomic<std::size_t> records_dropped_{0};
+    std::atomic<std::size_t> send_calls_{0};
+
+    static constexpr std::size_t MaxMessagesPerCall = 64;
+    static constexpr std::chrono::milliseconds ReconnectDelay{1000};
+
+    // Поле заголовка: печатные ASCII без пробелов, иначе "-" (RFC 5424, 6.2)
+    static std::string headerField(const std::string& value, std::size_t max_length) {
+        std::string field;
+        for (char c : value) {
+            if (c > 32 && c < 127 && field.size() < max_length) {
+                field += c;
+            }
+        }
+        return field.empty() ? "-" : field;
+    }
+
+    bool connectSocket() {
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_connect_attempt_) {
+            return false;
+        }
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path_.size() >= sizeof(address.sun_path)) {
+            next_connect_attempt_ = now + ReconnectDelay;
+            return false;
+        }
+        std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+        int fd = ::socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            socket_ = fd;
+            return true;
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        next_connect_attempt_ = now + ReconnectDelay;
+        return false;
+    }
+
+    void disconnect() {
+        if (socket_ >= 0) {
+            ::close(socket_);
+            socket_ = -1;
+        }
+    }
+
+    // Время по RFC 3339 в UTC с микросекундами; дата и время до секунд
+    // пересчитываются раз в секунду. Вызывается под mutex_
+    void appendTimestamp(std::string& out, std::int64_t epoch_ns) {
+        std::time_t seconds = static_cast<std::time_t>(epoch_ns / 1000000000);
+        long micros = static_cast<long>((epoch_ns % 1000000000) / 1000);
+        if (seconds != cached_second_) {
+            std::tm parts{};
+            ::gmtime_r(&seconds, &parts);
+            std::strftime(cached_prefix_, sizeof(cached_prefix_), "%Y-%m-%dT%H:%M:%S", &parts);
+            cached_second_ = seconds;
+        }
+        char fraction[16];
+        std::snprintf(fraction, sizeof(fraction), ".%06ldZ", micros);
+        out += cached_prefix_;
+        out += fraction;
+    }
+
+    // Отправляет записи группами по MaxMessagesPerCall; возвращает число
+    // отправленных записей с начала batch
+    std::size_t sendBatch(const std::vector<std::string>& batch) {
+        if (socket_ < 0 && !connectSocket()) {
+            return 0;
+        }
+        std::size_t sent = 0;
+        while (sent < batch.size()) {
+            std::size_t count = std::min(MaxMessagesPerCall, batch.size() - sent);
+#ifdef __linux__
+            mmsghdr messages[MaxMessagesPerCall];
+            iovec vectors[MaxMessagesPerCall];
+            std::memset(messages, 0, sizeof(mmsghdr) * count);
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::string& frame = batch[sent + i];
+                vectors[i].iov_base = const_cast<char*>(frame.data());
+                vectors[i].iov_len = frame.size();
+                messages[i].msg_hdr.msg_iov = &vectors[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int result = ::sendmmsg(socket_, messages, static_cast<unsigned int>(count), MSG_NOSIGNAL);
+#else
+            int result = 0;
+            while (static_cast<std::size_t>(result) < count &&
+                   ::send(socket_, batch[sent + result].data(), batch[sent + result].size(), MSG_NOSIGNAL) >= 0) {
+                ++result;
+            }
+            if (result == 0) {
+                result = -1;
+            }
+#endif
+            send_calls_.fetch_add(1, std::memory_order_relaxed);
+            if (result < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // Приёмник пропал или переполнен: переподключимся позже
+                disconnect();
+                next_connect_attempt_ = std::chrono::steady_clock::now() + ReconnectDelay;
+                break;
+            }
+            sent += static_cast<std::size_t>(result);
+        }
+        return sent;
+    }
+
+    void workerLoop() {
+        std::vector<std::string> batch;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            wakeup_.wait_for(lock, flush_interval_, [this] {
+                return stopping_ || flush_requests_ != flush_done_ || pending_.size() >= batch_size_;
+            });
+            bool stopping = stopping_;
+            std::size_t served = flush_requests_;
+
+            bool failed = false;
+            if (!pending_.empty()) {
+                batch.swap(pending_);
+                lock.unlock();
+                std::size_t sent = sendBatch(batch);
+                records_sent_.fetch_add(sent, std::memory_order_relaxed);
+                lock.lock();
+                failed = sent < batch.size();
+                if (failed) {
+                    // Неотправленный хвост возвращается в начало очереди, если есть место
+                    std::size_t rest = batch.size() - sent;
+                    if (!stopping && rest + pending_.size() <= max_pending_) {
+                        pending_.insert(pending_.begin(),
+                                        std::make_move_iterator(batch.begin() + static_cast<std::ptrdiff_t>(sent)),
+                                        std::make_move_iterator(batch.end()));
+                    } else {
+                        records_dropped_.fetch_add(rest, std::memory_order_relaxed);
+                    }
+                }
+                batch.clear();
+            }
+            flush_done_ = served;
+            flushed_.notify_all();
+
+            if (stopping) {
+                records_dropped_.fetch_add(pending_.size(), std::memory_order_relaxed);
+                pending_.clear();
+                break;
+            }
+            if (failed) {
+                wakeup_.wait_until(lock, next_connect_attempt_, [this] {
+                    return stopping_ || flush_requests_ != flush_done_;
+                });
+            }
+        }
+        stopped_ = true;
+        flushed_.notify_all();
+        lock.unlock();
+        disconnect();
+    }
+
+public:
+    // facility - номер по RFC 5424 (1 - user, 16..23 - local0..local7)
+    explicit SyslogSender(const std::string& path = "/dev/log",
+                          const std::string& app_name = "logging_system",
+                          int facility = 1,
+                          std::size_t batch_size = 32,
+                          std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100),
+                          std::size_t max_pending = 16384,
+                          std::size_t max_message = 2048)
+        : path_(path), facility_(std::clamp(facility, 0, 23)),
+          batch_size_(std::max<std::size_t>(batch_size, 1)), max_pending_(max_pending),
+          max_message_(std::max<std::size_t>(max_message, 128)), flush_interval_(flush_interval) {
+        char host[256] = {};
+        ::gethostname(host, sizeof(host) - 1);
+        header_tail_ = " " + headerField(host, 255) + " " + headerField(app_name, 48) + " " +
+                       std::to_string(::getpid()) + " - - ";
+        pending_.reserve(batch_size_ * 2);
+        worker_ = std::thread(&SyslogSender::workerLoop, this);
+    }
+
+    SyslogSender(const SyslogSender&) = delete;
+    SyslogSender& operator=(const SyslogSender&) = delete;
+
+    ~SyslogSender() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    void send(SyslogSeverity severity, std::int64_t epoch_ns, const char* data, std::size_t size) {
+        std::string frame;
+        frame.reserve(64 + header_tail_.size() + size);
+        frame += '<';
+        frame += std::to_string(facility_ * 8 + static_cast<int>(severity));
+        frame += ">1 ";
+
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.size() >= max_pending_) {
+                records_dropped_.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            appendTimestamp(frame, epoch_ns);
+            frame += header_tail_;
+            frame.append(data, std::min(size, max_message_ > frame.size() ? max_message_ - frame.size() : 0));
+            pending_.push_back(std::move(frame));
+            wake = pending_.size() >= batch_size_;
+        }
+        if (wake) {
+            wakeup_.notify_one();
+        }
+    }
+
+    // Ждёт одной попытки отправить всё, что накоплено к моменту вызова
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return;
+        }
+        std::size_t ticket = ++flush_requests_;
+        wakeup_.notify_one();
+        flushed_.wait(lock, [this, ticket] { return stopped_ || flush_done_ >= ticket; });
+    }
+
+    std::size_t recordsSent() const {
+        return records_sent_.load(std::memory_order_relaxed);
+    }
+
+    std::size_t recordsDropped() const {
+        return records_dropped_.load(std::memory_order_relaxed);
+    }
+
+    // Число системных вызовов отправки (для оценки пакетирования)
+    std::size_t sendCalls() const {
+        return send_calls_.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,249 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <cstring>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LOGGER_HAS_TSC 1
+#else
+#define LOGGER_HAS_TSC 0
+#endif
+
+// Точность дробной части секунды
+enum class TimestampPrecision {
+    MILLI,
+    MICRO,
+    NANO
+};
+
+// Источник времени
+enum class ClockSource {
+    SYSTEM, // std::chrono::system_clock
+    TSC     // счётчик тактов, подстраиваемый под system_clock раз в секунду
+};
+
+// Отрисовка меток вида "YYYY.MM.DD HH:MM:SS.mmm".
+// Часть до секунд кешируется в thread_local, поэтому localtime и форматирование
+// выполняются раз в секунду на поток, а на каждую запись дописываются только
+// цифры дробной части. Блокировок нет, движок можно вызывать из любых потоков.
+// Частота TSC известна лишь приблизительно, а system_clock подводит NTP,
+// поэтому раз в ResyncInterval now() сверяется с system_clock: расхождение
+// до MaxSlew убирается плавно за следующий интервал (время не идёт назад),
+// больше - скачком (часы переставили)
+class TimestampEngine {
+private:
+    static constexpr std::size_t PrefixLength = 19; // "YYYY.MM.DD HH:MM:SS"
+
+    struct SecondCache {
+        std::int64_t second = INT64_MIN;
+        char prefix[PrefixLength];
+    };
+
+    TimestampPrecision precision_;
+    ClockSource clock_;
+
+    static constexpr std::int64_t ResyncInterval = 1000000000; // нс
+    static constexpr std::int64_t MaxSlew = 50000000;          // нс
+
+    // Калибровка TSC: время = base_ns + (tsc - base_tsc) * ns_per_tick
+    struct Calibration {
+        std::uint64_t base_tsc;
+        std::int64_t base_ns;
+        double ns_per_tick;
+    };
+
+    // Калибровку меняет один поток, читают все: seqlock, нечётный sequence_ -
+    // идёт запись
+    mutable std::atomic<std::uint32_t> sequence_{0};
+    mutable std::atomic<std::uint64_t> base_tsc_{0};
+    mutable std::atomic<std::int64_t> base_ns_{0};
+    mutable std::atomic<double> ns_per_tick_{0.0};
+    mutable std::atomic<std::uint64_t> resync_ticks_{0};
+
+    // Последняя сверка с system_clock; только у владельца resyncing_
+    mutable std::atomic<bool> resyncing_{false};
+    mutable std::uint64_t sync_tsc_ = 0;
+    mutable std::int64_t sync_ns_ = 0;
+
+    static std::int64_t systemNowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static std::uint64_t readTsc() {
+#if LOGGER_HAS_TSC
+        return __rdtsc();
+#else
+        return 0;
+#endif
+    }
+
+    void calibrate() {
+        std::uint64_t tsc0 = readTsc();
+        std::int64_t ns0 = systemNowNs();
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::uint64_t tsc1 = readTsc();
+        std::int64_t ns1 = systemNowNs();
+        if (tsc1 <= tsc0 || ns1 <= ns0) {
+            clock_ = ClockSource::SYSTEM;
+            return;
+        }
+        storeCalibration({tsc1, ns1, static_cast<double>(ns1 - ns0) / static_cast<double>(tsc1 - tsc0)});
+        sync_tsc_ = tsc1;
+        sync_ns_ = ns1;
+    }
+
+    Calibration loadCalibration() const {
+        for (;;) {
+            std::uint32_t before = sequence_.load(std::memory_order_acquire);
+            Calibration calibration{base_tsc_.load(std::memory_order_relaxed),
+                                    base_ns_.load(std::memory_order_relaxed),
+                                    ns_per_tick_.load(std::memory_order_relaxed)};
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if ((before & 1) == 0 && sequence_.load(std::memory_order_relaxed) == before) {
+                return calibration;
+            }
+        }
+    }
+
+    void storeCalibration(const Calibration& calibration) const {
+        sequence_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        base_tsc_.store(calibration.base_tsc, std::memory_order_relaxed);
+        base_ns_.store(calibration.base_ns, std::memory_order_relaxed);
+        ns_per_tick_.store(calibration.ns_per_tick, std::memory_order_relaxed);
+        resync_ticks_.store(static_cast<std::uint64_t>(ResyncInterval / calibration.ns_per_tick),
+                            std::memory_order_relaxed);
+        sequence_.fetch_add(1, std::memory_order_release);
+    }
+
+    static std::int64_t project(const Calibration& calibration, std::uint64_t tsc) {
+        return calibration.base_ns + static_cast<std::int64_t>(
+            static_cast<double>(static_cast<std::int64_t>(tsc - calibration.base_tsc)) * calibration.ns_per_tick);
+    }
+
+    // Новая частота - по system_clock за прошедший интервал, плюс поправка,
+    // которая сводит расхождение к нулю к следующей сверке
+    void resync(std::uint64_t tsc) const {
+        if (resyncing_.exchange(true, std::memory_order_acquire)) {
+            return; // сверяет другой поток
+        }
+        std::int64_t ns = systemNowNs();
+        Calibration current = loadCalibration();
+        if (tsc - current.base_tsc >= resync_ticks_.load(std::memory_order_relaxed) && tsc > sync_tsc_) {
+            double ticks = static_cast<double>(tsc - sync_tsc_);
+            double measured = static_cast<double>(ns - sync_ns_) / ticks;
+            std::int64_t predicted = project(current, tsc);
+            std::int64_t error = ns - predicted;
+            Calibration next{tsc, predicted, measured + static_cast<double>(error) / ticks};
+            if (error > MaxSlew || error < -MaxSlew || measured <= 0.0 || next.ns_per_tick <= 0.0) {
+                next = {tsc, ns, measured > 0.0 ? measured : current.ns_per_tick};
+            }
+            storeCalibration(next);
+            sync_tsc_ = tsc;
+            sync_ns_ = ns;
+        }
+        resyncing_.store(false, std::memory_order_release);
+    }
+
+    static void putDigits(char* out, std::uint32_t value, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    static void renderPrefix(std::int64_t second, char* out) {
+        std::time_t time = static_cast<std::time_t>(second);
+        std::tm tm{};
+        localtime_r(&time, &tm);
+        putDigits(out, static_cast<std::uint32_t>(tm.tm_year + 1900), 4);
+        out[4] = '.';
+        putDigits(out + 5, static_cast<std::uint32_t>(tm.tm_mon + 1), 2);
+        out[7] = '.';
+        putDigits(out + 8, static_cast<std::uint32_t>(tm.tm_mday), 2);
+        out[10] = ' ';
+        putDigits(out + 11, static_cast<std::uint32_t>(tm.tm_hour), 2);
+        out[13] = ':';
+        putDigits(out + 14, static_cast<std::uint32_t>(tm.tm_min), 2);
+        out[16] = ':';
+        putDigits(out + 17, static_cast<std::uint32_t>(tm.tm_sec), 2);
+    }
+
+public:
+    // Максимальная длина результата render()
+    static constexpr std::size_t MaxLength = PrefixLength + 10;
+
+    explicit TimestampEngine(TimestampPrecision precision = TimestampPrecision::MILLI,
+                             ClockSource clock = ClockSource::SYSTEM)
+        : precision_(precision), clock_(clock) {
+        if (clock_ == ClockSource::TSC) {
+            if (LOGGER_HAS_TSC) {
+                calibrate();
+            } else {
+                clock_ = ClockSource::SYSTEM;
+            }
+        }
+    }
+
+    TimestampEngine(const TimestampEngine&) = delete;
+    TimestampEngine& operator=(const TimestampEngine&) = delete;
+
+    // Текущее время в наносекундах от эпохи
+    std::int64_t now() const {
+        if (clock_ == ClockSource::TSC) {
+            std::uint64_t tsc = readTsc();
+            Calibration calibration = loadCalibration();
+            if (static_cast<std::int64_t>(tsc - calibration.base_tsc) >=
+                static_cast<std::int64_t>(resync_ticks_.load(std::memory_order_relaxed))) {
+                resync(tsc);
+            }
+            return project(calibration, tsc);
+        }
+        return systemNowNs();
+    }
+
+    // Пишет метку в out (не менее MaxLength байт) и возвращает её длину
+    std::size_t render(std::int64_t epoch_ns, char* out) const {
+        std::int64_t second = epoch_ns / 1000000000;
+        std::int64_t nanos = epoch_ns % 1000000000;
+        if (nanos < 0) {
+            nanos += 1000000000;
+            --second;
+        }
+
+        static thread_local SecondCache cache;
+        if (cache.second != second) {
+            renderPrefix(second, cache.prefix);
+            cache.second = second;
+        }
+        std::memcpy(out, cache.prefix, PrefixLength);
+        out[PrefixLength] = '.';
+
+        switch (precision_) {
+            case TimestampPrecision::MILLI:
+                putDigits(out + PrefixLength + 1, static_cast<std::uint32_t>(nanos / 1000000), 3);
+                return PrefixLength + 4;
+            case TimestampPrecision::MICRO:
+                putDigits(out + PrefixLength + 1, static_cast<std::uint32_t>(nanos / 1000), 6);
+                return PrefixLength + 7;
+            case TimestampPrecision::NANO:
+            default:
+                putDigits(out + PrefixLength + 1, static_cast<std::uint32_t>(nanos), 9);
+                return PrefixLength + 10;
+        }
+    }
+
+    std::size_t renderNow(char* out) const {
+        return render(now(), out);
+    }
+
+    ClockSource clock() const {
+        return clock_;
+    }
+};
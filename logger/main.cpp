@@ -1,258 +1,50 @@
 #include <iostream>
-#include <string>
-#include <vector>
 #include <memory>
-#include <fstream>
-#include <regex>
-#include <chrono>
-#include <iomanip>
-#include <sstream>
-#include <locale>
-#include <codecvt>
-
-enum class LogLevel {
-    INFO,
-    WARN,
-    ERROR
-};
-
-// Вспомогательная функция для преобразования LogLevel в строку
-std::string logLevelToString(LogLevel level) {
-    switch (level) {
-        case LogLevel::INFO: return "INFO";
-        case LogLevel::WARN: return "WARN";
-        case LogLevel::ERROR: return "ERROR";
-        default: return "UNKNOWN";
-    }
-}
-
-// Абстрактный класс фильтров
-class ILogFilter {
-public:
-    virtual ~ILogFilter() = default;
-    virtual bool match(LogLevel log_level, const std::string& text) = 0;
-};
-
-
-
-// фильтрация по вхождению текста
-class SimpleLogFilter : public ILogFilter {
-private:
-    std::string pattern_;
-public:
-    explicit SimpleLogFilter(const std::string& pattern) : pattern_(pattern) {}
-    
-    bool match(LogLevel log_level, const std::string& text) override {
-        return text.find(pattern_) != std::string::npos;
-    }
-};
-
-// фильтрация по регулярному выражению
-class ReLogFilter : public ILogFilter {
-private:
-    std::regex pattern_;
-public:
-    explicit ReLogFilter(const std::string& pattern) : pattern_(pattern) {}
-    
-    bool match(LogLevel log_level, const std::string& text) override {
-        return std::regex_search(text, pattern_);
-    }
-};
-
-// фильтрация по уровню логирования
-class LevelFilter : public ILogFilter {
-private:
-    LogLevel min_level_;
-public:
-    explicit LevelFilter(LogLevel min_level) : min_level_(min_level) {}
-    
-    bool match(LogLevel log_level, const std::string& text) override {
-        return static_cast<int>(log_level) >= static_cast<int>(min_level_);
-    }
-};
-
-// Абстрактный класс обработчиков
-class ILogHandler {
-public:
-    virtual ~ILogHandler() = default;
-    virtual void handle(LogLevel log_level, const std::string& text) = 0;
-};
-
-// Абстрактный класс форматтеров
-class ILogFormatter {
-public:
-    virtual ~ILogFormatter() = default;
-    virtual std::string format(LogLevel log_level, const std::string& text) = 0;
-};
-
-// Реализация форматтера с временной меткой
-class TimestampFormatter : public ILogFormatter {
-public:
-    std::string format(LogLevel log_level, const std::string& text) override {
-        auto now = std::chrono::system_clock::now();
-        auto time_t = std::chrono::system_clock::to_time_t(now);
-        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-            now.time_since_epoch()) % 1000;
-        
-        std::stringstream ss;
-        ss << std::put_time(std::localtime(&time_t), "%Y.%m.%d %H:%M:%S");
-        ss << "." << std::setfill('0') << std::setw(3) << ms.count();
-        
-        return "[" + logLevelToString(log_level) + "] [" + ss.str() + "] " + text;
-    }
-};
-
-
-// вывод в консоль
-class ConsoleHandler : public ILogHandler {
-private:
-    std::string getColorCode(LogLevel level) {
-        switch (level) {
-            case LogLevel::INFO: return "\033[32m";  // Зеленый
-            case LogLevel::WARN: return "\033[33m";  // Желтый
-            case LogLevel::ERROR: return "\033[31m"; // Красный
-            default: return "\033[0m";               // Сброс
-        }
-    }
-    
-public:
-    void handle(LogLevel log_level, const std::string& text) override {
-        std::cout << getColorCode(log_level) << text << "\033[0m" << std::endl;
-    }
-};
-
-// запись в файл
-class FileHandler : public ILogHandler {
-private:
-    std::ofstream file_;
-public:
-    explicit FileHandler(const std::string& filename) {
-        file_.open(filename, std::ios::app);
-    }
-    
-    ~FileHandler() {
-        if (file_.is_open()) {
-            file_.close();
-        }
-    }
-    
-    void handle(LogLevel log_level, const std::string& text) override {
-        if (file_.is_open()) {
-            file_ << text << std::endl;
-        }
-    }
-};
-
-// имитация отправки через сокет
-class SocketHandler : public ILogHandler {
-private:
-    std::string address_;
-    int port_;
-public:
-    SocketHandler(const std::string& address, int port) 
-        : address_(address), port_(port) {}
-    
-    void handle(LogLevel log_level, const std::string& text) override {
-        std::cout << "[SOCKET to " << address_ << ":" << port_ << "] " << text << std::endl;
-    }
-};
-
-// имитация записи в системные логи
-class SyslogHandler : public ILogHandler {
-public:
-    void handle(LogLevel log_level, const std::string& text) override {
-        std::cout << "[SYSLOG] " << text << std::endl;
-    }
-};
-
-// имитация записи на FTP сервер
-class FtpHandler : public ILogHandler {
-private:
-    std::string server_;
-    std::string path_;
-public:
-    FtpHandler(const std::string& server, const std::string& path = "")
-        : server_(server), path_(path) {}
-    
-    void handle(LogLevel log_level, const std::string& text) override {
-        std::cout << "[FTP to " << server_ << path_ << "] " << text << std::endl;
-    }
-};
-
-// Основной класс
-class Logger {
-private:
-    std::vector<std::unique_ptr<ILogFilter>> filters_;
-    std::vector<std::unique_ptr<ILogFormatter>> formatters_;
-    std::vector<std::unique_ptr<ILogHandler>> handlers_;
-
-public:
-    // Добавление фильтров, форматтеров и обработчиков
-    void addFilter(std::unique_ptr<ILogFilter> filter) {
-        filters_.push_back(std::move(filter));
-    }
-    
-    void addFormatter(std::unique_ptr<ILogFormatter> formatter) {
-        formatters_.push_back(std::move(formatter));
-    }
-    
-    void addHandler(std::unique_ptr<ILogHandler> handler) {
-        handlers_.push_back(std::move(handler));
-    }
-    
-    // Основной метод логирования
-    void log(LogLevel log_level, const std::string& text) {
-        // Применяем фильтры
-        for (const auto& filter : filters_) {
-            if (!filter->match(log_level, text)) {
-                return; // Сообщение не прошло фильтр
-            }
-        }
-        
-        std::string formatted_text = text;
-        
-        // Применяем форматтеры
-        for (const auto& formatter : formatters_) {
-            formatted_text = formatter->format(log_level, formatted_text);
-        }
-        
-        // Передаем обработчикам
-        for (const auto& handler : handlers_) {
-            handler->handle(log_level, formatted_text);
-        }
-    }
-    
-    // Удобные методы для разных уровней логирования
-    void log_info(const std::string& text) {
-        log(LogLevel::INFO, text);
-    }
-    
-    void log_warn(const std::string& text) {
-        log(LogLevel::WARN, text);
-    }
-    
-    void log_error(const std::string& text) {
-        log(LogLevel::ERROR, text);
-    }
-};
-
+#include <string>
+#include "logger.hpp"
 
 int main() {
     Logger logger;
     
-    logger.addFilter(std::make_unique<LevelFilter>(LogLevel::INFO)); // Фильтр по уровню
+    // Общий уровень - уровень корневого логгера: дочерние логгеры могут его
+    // переопределить ("net.http = DEBUG"), а LevelFilter отсёк бы и их записи
+    logger.setModuleLevel("root", LogLevel::INFO);
     // logger.addFilter(std::make_unique<SimpleLogFilter>("important")); // Фильтр по тексту
     // logger.addFilter(std::make_unique<ReLogFilter>("(error|warning|info)")); // Фильтр по regex
+    // logger.addFilter(std::make_unique<KeywordLogFilter>(
+    //     std::vector<std::string>{"important", "error", "warning"})); // Фильтр по списку слов
+    // logger.addFilter(std::make_unique<FieldFilter>("latency_us", FieldOp::GREATER, 1000)); // Фильтр по полю
+    // logger.addFilter(std::make_unique<RateLimitFilter>(100.0, 20)); // Не больше 100 одинаковых записей в секунду
+    // logger.enableDeduplication(DedupMode::TEMPLATE); // Повторы подряд -> "last message repeated N times"
+    // logger.configureLevels("levels.conf"); // "net.http = DEBUG" и т.п., файл перечитывается при изменении
     
     // Добавляем форматтер с временной меткой
     logger.addFormatter(std::make_unique<TimestampFormatter>());
     
     // Добавляем обработчики
     logger.addHandler(std::make_unique<ConsoleHandler>());
-    logger.addHandler(std::make_unique<FileHandler>("app.log"));
+    // Файл ротируется по 64 МиБ, закрытые части сжимаются в фоне в app.log.<время>.lz
+    auto file_handler = std::make_unique<FileHandler>("app.log");
+    // file_handler->setFieldFormat(FieldFormat::JSON); // Строки JSON вместо текста
+    file_handler->enableRotation(64 * 1024 * 1024, std::make_shared<BackgroundCompressor>());
+    // file_handler->enableIndex(); // app.log.idx для запросов: log_query app.log --level ERROR
+    logger.addHandler(std::move(file_handler));
+    // logger.addHandler(std::make_unique<MappedFileHandler>("logs")); // Сегменты с ротацией
+    // Обработчики вызываются из фонового потока Logger; сетевые только кладут
+    // запись в очередь, а отправляют её свои потоки (SocketHandler - пачками)
     logger.addHandler(std::make_unique<SocketHandler>("localhost", 514));
     logger.addHandler(std::make_unique<SyslogHandler>());
+    // FTP: записи копятся в ftp_spool/, сегменты выгружает отдельный поток;
+    // при недоступном сервере они ждут следующего запуска (не больше 64);
+    // FtpHandler("file://ftp_drop", "/logs/") складывает их в локальный каталог
     logger.addHandler(std::make_unique<FtpHandler>("ftp.example.com", "/logs/"));
+
+    // При падении процесса буферы и очередь записей сбрасываются в файлы
+    logger.enableCrashFlush();
+    // logger.exportMetrics("logger_metrics.prom"); // Счётчики фильтров, задержки обработчиков, очередь
+
+    // Обработчики выполняются в фоновом потоке
+    logger.startAsync();
     
     std::cout << "=== Demonstration of Logging System ===" << std::endl;
     
@@ -264,6 +56,30 @@ int main() {
     // Сообщения, которые не пройдут фильтры (если они включены)
     logger.log_info("This message will be processed (filters are simplified)");
     logger.log_info("Message with important keyword will be processed");
+
+    // Уровень DEBUG отключен у корневого логгера, поэтому сообщение даже не строится
+    for (int i = 0; i < 1000; ++i) {
+        LOG_DEBUG(logger, "Iteration " + std::to_string(i));
+    }
+    logger.log_warn([] { return std::string("Lazy message built only for enabled levels"); });
+
+    // Структурированная запись: поля хранятся в записи в двоичном виде
+    logger.log_info("Request completed", {{"user_id", 42}, {"latency_us", 1.3}, {"path", "/api/items"}});
+
+    // Отложенное форматирование: при logger.enableBinaryLog("app.blog") запись
+    // сохраняется в двоичном виде, текст получает tools/log_decode
+    LOG_DEFERRED(logger, LogLevel::INFO, "user {} took {} us", 42, 17.5);
+
+    // Строка формата проверяется компилятором: LOGF_INFO(logger, "user {} took {} us", 42)
+    // не соберётся из-за недостающего аргумента
+    LOGF_INFO(logger, "user {} took {:.2f} us, flags {:x}", 42, 17.5, 255u);
+
+    // Дочерние логгеры со своими уровнями, наследуемыми по точкам в имени
+    ModuleLogger& http = logger.getLogger("net.http");
+    http.log_info("GET /api/items 200");
+    LOGF_WARN(http.child("client"), "retry {} of {}", 1, 3);
+
+    logger.flush();
     
     std::cout << "\n=== Demonstration completed ===" << std::endl;
     
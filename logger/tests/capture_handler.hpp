@@ -0,0 +1,14 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+
+// Обработчик для тестов: складывает текст записей в вектор
+struct CaptureHandler : ILogHandler {
+    std::vector<std::string>& lines;
+    explicit CaptureHandler(std::vector<std::string>& out) : lines(out) {}
+    void handle(LogLevel, const std::string& text) override {
+        lines.push_back(text);
+    }
+};
@@ -0,0 +1,84 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+#include "test_util.hpp"
+
+static std::vector<std::string> readLines(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream in(path);
+    for (std::string line; std::getline(in, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static bool endsWith(const std::string& text, const std::string& tail) {
+    return text.size() >= tail.size() && text.compare(text.size() - tail.size(), tail.size(), tail) == 0;
+}
+
+// Записи LOG_DEFERRED восстанавливаются log_decode с уровнем и аргументами
+TEST(deferred_log_round_trip_through_log_decode) {
+    test::TempDir dir;
+    std::string path = dir.file("app.blog");
+    {
+        Logger logger;
+        logger.enableBinaryLog(path);
+        LOG_DEFERRED(logger, LogLevel::INFO, "user {} took {} us", 42, 17.5);
+        LOG_DEFERRED(logger, LogLevel::WARN, "name={} ok={}", std::string("tab\there"), true);
+        LOG_DEFERRED(logger, LogLevel::ERROR, "code {}", -7);
+        logger.flush();
+    }
+    std::string out = dir.file("out.txt");
+    std::string command = std::string(LOG_DECODE) + " " + path + " > " + out;
+    CHECK_EQ(std::system(command.c_str()), 0);
+    std::vector<std::string> lines = readLines(out);
+    CHECK_EQ(lines.size(), 3u);
+    if (lines.size() == 3) {
+        CHECK(lines[0].compare(0, 7, "[INFO] ") == 0);
+        CHECK(endsWith(lines[0], "] user 42 took 17.5 us"));
+        CHECK(lines[1].compare(0, 7, "[WARN] ") == 0);
+        CHECK(endsWith(lines[1], "] name=tab\there ok=true"));
+        CHECK(lines[2].compare(0, 8, "[ERROR] ") == 0);
+        CHECK(endsWith(lines[2], "] code -7"));
+    }
+}
+
+// id, занятый в таблице прошлого запуска другим форматом, не переиспользуется:
+// запись получает следующий свободный id, и её текст не подменяется старым форматом
+TEST(deferred_log_skips_ids_taken_by_old_formats) {
+    test::TempDir dir;
+    std::string path = dir.file("app.blog");
+    std::string signature = DeferredArgs::signature<int>();
+    const DeferredFormat* format = DeferredFormatRegistry::instance().intern("fresh {}", signature);
+    CHECK(format != nullptr);
+    if (format == nullptr) {
+        return;
+    }
+    {
+        DeferredFormat old{format->id, 0, "stale {}", signature};
+        std::ofstream table(path + ".fmt");
+        table << FormatTableLine::make(format->id, old);
+    }
+    {
+        Logger logger;
+        logger.enableBinaryLog(path);
+        LOG_DEFERRED(logger, LogLevel::INFO, "fresh {}", 5);
+        logger.flush();
+    }
+    CHECK_EQ(readLines(path + ".fmt").size(), 2u);
+
+    BinaryLogReader reader(path, path + ".fmt");
+    CHECK(reader.good());
+    BinaryRecordHeader header;
+    std::string text;
+    CHECK(reader.next(header, text));
+    CHECK(header.format_id != format->id);
+    CHECK(text == "fresh 5");
+    CHECK(!reader.next(header, text));
+}
+
+TEST_MAIN()
@@ -0,0 +1,71 @@
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "lz_codec.hpp"
+#include "test_util.hpp"
+
+static bool roundTrip(const std::vector<std::uint8_t>& input) {
+    std::vector<std::uint8_t> packed(LzCodec::maxCompressedSize(input.size()));
+    std::size_t packed_size = LzCodec::compressBlock(input.data(), input.size(), packed.data());
+    if (packed_size > packed.size()) {
+        return false;
+    }
+    std::vector<std::uint8_t> output(input.size());
+    return LzCodec::decompressBlock(packed.data(), packed_size, output.data(), output.size()) &&
+           output == input;
+}
+
+TEST(lz_round_trip_text_and_random) {
+    std::mt19937 random(42);
+    for (int round = 0; round < 200; ++round) {
+        std::vector<std::uint8_t> input;
+        std::size_t size = random() % 70000;
+        // Повторяющийся "журнал" с вкраплениями случайных байт
+        while (input.size() < size) {
+            if (random() % 4 == 0) {
+                input.push_back(static_cast<std::uint8_t>(random()));
+            } else {
+                std::string line = "[INFO] [2024.05.01 13:00:0" + std::to_string(random() % 10) + "] request done\n";
+                input.insert(input.end(), line.begin(), line.end());
+            }
+        }
+        input.resize(size);
+        CHECK(roundTrip(input));
+    }
+}
+
+TEST(lz_rejects_truncated_input) {
+    std::vector<std::uint8_t> input(10000, 'a');
+    std::vector<std::uint8_t> packed(LzCodec::maxCompressedSize(input.size()));
+    std::size_t packed_size = LzCodec::compressBlock(input.data(), input.size(), packed.data());
+    std::vector<std::uint8_t> output(input.size());
+    CHECK(!LzCodec::decompressBlock(packed.data(), packed_size / 2, output.data(), output.size()));
+}
+
+TEST(lz_file_round_trip) {
+    test::TempDir dir;
+    std::string source = dir.file("app.log");
+    std::string expected;
+    {
+        std::ofstream out(source);
+        for (int i = 0; i < 50000; ++i) {
+            std::string line = "[WARN] record " + std::to_string(i);
+            out << line << '\n';
+            expected += line + '\n';
+        }
+    }
+    CHECK(LzCodec::compressFile(source, source + ".lz"));
+    LzFileReader reader(source + ".lz");
+    CHECK(reader.good());
+    std::string actual;
+    std::string line;
+    while (reader.getline(line)) {
+        actual += line + '\n';
+    }
+    CHECK(actual == expected);
+}
+
+TEST_MAIN()
@@ -0,0 +1,74 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "background_compressor.hpp"
+#include "test_util.hpp"
+
+static void writeFile(const std::string& path, int lines) {
+    std::ofstream out(path);
+    for (int i = 0; i < lines; ++i) {
+        out << "record " << i << '\n';
+    }
+}
+
+static bool exists(const std::string& path) {
+    return std::filesystem::exists(path);
+}
+
+static bool waitIdle(const BackgroundCompressor& compressor, std::size_t compressed) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (compressor.compressedCount() < compressed || compressor.pending() > 0) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+// Файлы сверх очереди откладываются и сжимаются, когда она опустеет
+TEST(compressor_requeues_overflow) {
+    test::TempDir dir;
+    constexpr int Files = 20;
+    for (int i = 0; i < Files; ++i) {
+        writeFile(dir.file("app.log." + std::to_string(1000 + i)), 20000);
+    }
+    BackgroundCompressor compressor(1);
+    int rejected = 0;
+    for (int i = 0; i < Files; ++i) {
+        rejected += compressor.submit(dir.file("app.log." + std::to_string(1000 + i))) ? 0 : 1;
+    }
+    CHECK(rejected > 0);
+    CHECK(waitIdle(compressor, Files));
+    int done = 0;
+    for (int i = 0; i < Files; ++i) {
+        std::string path = dir.file("app.log." + std::to_string(1000 + i));
+        done += exists(path + ".lz") && !exists(path) ? 1 : 0;
+    }
+    CHECK_EQ(done, Files);
+}
+
+// При запуске подбираются закрытые части без .lz, остальное не трогается
+TEST(compressor_picks_up_leftover_rotated_files) {
+    test::TempDir dir;
+    writeFile(dir.file("app.log"), 10);
+    writeFile(dir.file("app.log.100"), 10);
+    writeFile(dir.file("app.log.200-1"), 10);
+    writeFile(dir.file("app.log.300.lz"), 10);
+    writeFile(dir.file("app.log.idx"), 10);
+    writeFile(dir.file("other.log.400"), 10);
+    BackgroundCompressor compressor;
+    CHECK_EQ(compressor.submitRotated(dir.file("app.log")), 2u);
+    CHECK(waitIdle(compressor, 2));
+    CHECK(exists(dir.file("app.log.100.lz")));
+    CHECK(exists(dir.file("app.log.200-1.lz")));
+    CHECK(exists(dir.file("app.log")));
+    CHECK(exists(dir.file("app.log.idx")));
+    CHECK(exists(dir.file("other.log.400")));
+    CHECK(!exists(dir.file("app.log.300.lz.lz")));
+}
+
+TEST_MAIN()
@@ -0,0 +1,138 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.hpp"
+#include "mpsc_ring.hpp"
+#include "test_util.hpp"
+
+// Каждый производитель видит свои записи у потребителя по порядку и без потерь
+TEST(mpsc_ring_preserves_per_producer_order) {
+    constexpr int Producers = 4;
+    constexpr std::uint64_t PerProducer = 100000;
+    MpscRing<std::uint64_t> ring(64);
+    std::vector<std::thread> producers;
+    for (int p = 0; p < Producers; ++p) {
+        producers.emplace_back([&ring, p] {
+            for (std::uint64_t i = 0; i < PerProducer; ++i) {
+                std::uint64_t value = (static_cast<std::uint64_t>(p) << 32) | i;
+                while (!ring.tryPush(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<std::uint64_t> next(Producers, 0);
+    std::uint64_t received = 0;
+    bool ordered = true;
+    while (received < Producers * PerProducer) {
+        std::uint64_t value;
+        if (!ring.tryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::size_t producer = value >> 32;
+        ordered = ordered && producer < next.size() && (value & 0xFFFFFFFFu) == next[producer];
+        if (producer < next.size()) {
+            ++next[producer];
+        }
+        ++received;
+    }
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    CHECK(ordered);
+    CHECK_EQ(ring.pushedCount(), Producers * PerProducer);
+    CHECK_EQ(ring.sizeApprox(), 0u);
+}
+
+TEST(mpsc_ring_reports_full) {
+    MpscRing<int> ring(4);
+    for (int i = 0; i < 4; ++i) {
+        CHECK(ring.tryPush(int(i)));
+    }
+    CHECK(!ring.tryPush(99));
+    int pending = 0;
+    ring.forEachPending([&pending](const int&) { ++pending; });
+    CHECK_EQ(pending, 4);
+    int value = -1;
+    CHECK(ring.tryPop(value));
+    CHECK_EQ(value, 0);
+    CHECK(ring.tryPush(4));
+}
+
+TEST(bounded_queue_drop_newest) {
+    BoundedQueue<int> queue(2, OverflowPolicy::DROP_NEWEST);
+    CHECK(queue.push(1));
+    CHECK(queue.push(2));
+    CHECK(!queue.push(3));
+    CHECK_EQ(queue.dropped(), 1u);
+    int value = 0;
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, 1);
+}
+
+TEST(bounded_queue_drop_oldest) {
+    BoundedQueue<int> queue(2, OverflowPolicy::DROP_OLDEST);
+    queue.push(1);
+    queue.push(2);
+    CHECK(!queue.push(3));
+    CHECK_EQ(queue.dropped(), 1u);
+    int value = 0;
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, 2);
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, 3);
+}
+
+// Закреплённая запись в голове очереди не вытесняется, жертва - следующая
+TEST(bounded_queue_drop_oldest_skips_pinned) {
+    BoundedQueue<int> queue(3, OverflowPolicy::DROP_OLDEST, [](const int& value) { return value < 0; });
+    queue.push(-1);
+    queue.push(1);
+    queue.push(2);
+    CHECK(!queue.push(3));
+    int value = 0;
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, -1);
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, 2);
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, 3);
+    CHECK_EQ(queue.dropped(), 1u);
+}
+
+TEST(bounded_queue_block_waits_for_consumer) {
+    BoundedQueue<int> queue(1, OverflowPolicy::BLOCK);
+    queue.push(1);
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        queue.push(2);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!pushed);
+    int value = 0;
+    CHECK(queue.pop(value));
+    producer.join();
+    CHECK(pushed);
+    CHECK(queue.pop(value));
+    CHECK_EQ(value, 2);
+    CHECK_EQ(queue.dropped(), 0u);
+}
+
+TEST(bounded_queue_close_releases_waiters) {
+    BoundedQueue<int> queue(1, OverflowPolicy::BLOCK);
+    std::thread consumer([&] {
+        int value = 0;
+        CHECK(!queue.pop(value));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.close();
+    consumer.join();
+    CHECK(!queue.push(1));
+}
+
+TEST_MAIN()
@@ -0,0 +1,107 @@
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "logger.hpp"
+#include "test_util.hpp"
+
+struct CrashOutcome {
+    int signal = 0;
+    std::size_t unique = 0;
+    std::size_t duplicates = 0;
+    std::size_t torn = 0;
+};
+
+// Запускает body в дочернем процессе и разбирает файл: каждая строка должна
+// быть "record N" или "[LEVEL] [crash] record N"
+template<typename F>
+static CrashOutcome crashChild(const std::string& path, F&& body) {
+    CrashOutcome outcome;
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        body();
+        std::_Exit(0);
+    }
+    int status = 0;
+    ::waitpid(pid, &status, 0);
+    outcome.signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+
+    std::ifstream file(path);
+    std::set<long> seen;
+    for (std::string line; std::getline(file, line);) {
+        std::string_view rest = line;
+        if (rest.rfind("[INFO] [crash] ", 0) == 0) {
+            rest.remove_prefix(15);
+        }
+        if (rest.rfind("record ", 0) != 0 || rest.size() == 7 ||
+            rest.find_first_not_of("0123456789", 7) != std::string_view::npos) {
+            ++outcome.torn;
+            continue;
+        }
+        if (!seen.insert(std::stol(std::string(rest.substr(7)))).second) {
+            ++outcome.duplicates;
+        }
+    }
+    outcome.unique = seen.size();
+    return outcome;
+}
+
+// Асинхронный режим: запись уже в очереди или в буфере FileHandler, когда
+// процесс падает. После сброса в файле каждая запись ровно один раз
+TEST(crash_flush_async_keeps_every_record_once) {
+    constexpr int Records = 50000;
+    for (int run = 0; run < 5; ++run) {
+        test::TempDir dir;
+        std::string path = dir.file("app.log");
+        CrashOutcome outcome = crashChild(path, [&] {
+            Logger logger;
+            logger.addHandler(std::make_unique<FileHandler>(path, 64 * 1024, std::chrono::milliseconds(1)));
+            logger.enableCrashFlush();
+            logger.startAsync(1 << 16);
+            for (int i = 0; i < Records; ++i) {
+                logger.log_info("record " + std::to_string(i));
+            }
+            std::raise(SIGSEGV);
+        });
+        CHECK_EQ(outcome.signal, SIGSEGV);
+        CHECK_EQ(outcome.unique, static_cast<std::size_t>(Records));
+        CHECK_EQ(outcome.duplicates, 0u);
+        CHECK_EQ(outcome.torn, 0u);
+    }
+}
+
+// Синхронный режим: другие потоки пишут в тот же FileHandler во время
+// сбоя; строки не рвутся и не повторяются
+TEST(crash_flush_sync_does_not_tear_lines) {
+    for (int run = 0; run < 3; ++run) {
+        test::TempDir dir;
+        std::string path = dir.file("app.log");
+        CrashOutcome outcome = crashChild(path, [&] {
+            Logger logger;
+            logger.addHandler(std::make_unique<FileHandler>(path, 4096, std::chrono::milliseconds(1)));
+            logger.enableCrashFlush();
+            for (int t = 0; t < 4; ++t) {
+                std::thread([&logger, t] {
+                    for (long i = 0;; ++i) {
+                        logger.log_info("record " + std::to_string(t * 100000000L + i));
+                    }
+                }).detach();
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            std::abort();
+        });
+        CHECK_EQ(outcome.signal, SIGABRT);
+        CHECK(outcome.unique > 0);
+        CHECK_EQ(outcome.duplicates, 0u);
+        CHECK_EQ(outcome.torn, 0u);
+    }
+}
+
+TEST_MAIN()
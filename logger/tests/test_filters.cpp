@@ -0,0 +1,80 @@
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture_handler.hpp"
+#include "logger.hpp"
+#include "test_util.hpp"
+
+static bool sameTemplate(const std::string& a, const std::string& b) {
+    return KeyedRateLimiter::templateKey(a) == KeyedRateLimiter::templateKey(b);
+}
+
+// Десятичные и шестнадцатеричные значения не разделяют шаблон
+TEST(template_key_collapses_numbers) {
+    CHECK(sameTemplate("user 42 took 17 us", "user 7 took 3 us"));
+    CHECK(sameTemplate("ptr 0x7ffe12a0 freed", "ptr 0x55d0c3 freed"));
+    CHECK(sameTemplate("request 550e8400-e29b-41d4-a716-446655440000 failed",
+                       "request 6fa459ea-ee8a-3ca4-894e-db77e160355e failed"));
+    CHECK(sameTemplate("hash a3f9e0 mismatch", "hash 09c1ff mismatch"));
+    CHECK(sameTemplate("worker42 stopped", "worker7 stopped"));
+}
+
+// Слова остаются в ключе, даже если состоят из букв a-f
+TEST(template_key_keeps_words) {
+    CHECK(!sameTemplate("cache added", "cache faded"));
+    CHECK(!sameTemplate("user 42 took 17 us", "user 42 took 17 ms"));
+    CHECK(!sameTemplate("bad value 1", "good value 1"));
+}
+
+// KeywordLogFilter: одно слово, ANY и ALL по нескольким словам
+TEST(keyword_filter_matches_any_or_all) {
+    KeywordLogFilter single({"timeout"});
+    CHECK(single.match(LogLevel::INFO, "connect timeout after 5 s"));
+    CHECK(!single.match(LogLevel::INFO, "connected"));
+
+    KeywordLogFilter any({"timeout", "refused"});
+    CHECK(any.match(LogLevel::INFO, "connection refused"));
+    CHECK(any.match(LogLevel::INFO, "read timeout"));
+    CHECK(!any.match(LogLevel::INFO, "connected"));
+
+    KeywordLogFilter all({"disk", "full"}, KeywordMatchMode::ALL);
+    CHECK(all.match(LogLevel::INFO, "disk /var is full"));
+    CHECK(!all.match(LogLevel::INFO, "disk /var is ok"));
+}
+
+// Ключевые слова со всеми 256 значениями байта: у каждого байта свой класс,
+// и байт 0 не путается с последним добавленным байтом 0xff
+TEST(keyword_filter_handles_all_byte_values) {
+    std::string every_byte;
+    for (int byte = 0; byte < 256; ++byte) {
+        every_byte += static_cast<char>(byte);
+    }
+    KeywordLogFilter filter({every_byte, std::string("ab\xff")});
+    CHECK(filter.match(LogLevel::INFO, "xx ab\xff yy"));
+    CHECK(filter.match(LogLevel::INFO, "<" + every_byte + ">"));
+    CHECK(!filter.match(LogLevel::INFO, std::string("xx ab\0 yy", 8)));
+    CHECK(!filter.match(LogLevel::INFO, every_byte.substr(0, 255)));
+}
+
+// Синхронный режим: сводка по истёкшей серии выходит со следующей записью,
+// даже если её саму отбрасывает фильтр
+TEST(sync_dedup_releases_expired_burst) {
+    std::vector<std::string> lines;
+    Logger logger;
+    logger.addFilter(std::make_unique<SimpleLogFilter>("keep"));
+    logger.enableDeduplication(DedupMode::EXACT, std::chrono::milliseconds(50));
+    logger.addHandler(std::make_unique<CaptureHandler>(lines));
+    for (int i = 0; i < 5; ++i) {
+        logger.log_info("keep me");
+    }
+    CHECK_EQ(lines.size(), 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(80));
+    logger.log_info("filtered out");
+    CHECK_EQ(lines.size(), 2u);
+    CHECK(lines.size() == 2 && lines[1].rfind("last message repeated 4 times", 0) == 0);
+}
+
+TEST_MAIN()
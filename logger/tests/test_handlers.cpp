@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "capture_handler.hpp"
+#include "logger.hpp"
+#include "test_util.hpp"
+
+// Зависание - тоже провал: тест не должен ждать таймаута ctest
+template<typename F>
+static bool finishesWithin(std::chrono::seconds limit, F&& body) {
+    auto task = std::async(std::launch::async, std::forward<F>(body));
+    if (task.wait_for(limit) == std::future_status::ready) {
+        return true;
+    }
+    std::printf("  hung for %lld s\n", static_cast<long long>(limit.count()));
+    std::fflush(stdout);
+    std::_Exit(1);
+}
+
+struct SlowHandler : ILogHandler {
+    std::atomic<int>& flushes;
+    explicit SlowHandler(std::atomic<int>& counter) : flushes(counter) {}
+    void handle(LogLevel, const std::string&) override {
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    void flush() override {
+        ++flushes;
+    }
+};
+
+// Маркер сброса не вытесняется записями других потоков при DROP_OLDEST,
+// поэтому каждый flush() возвращается
+TEST(async_handler_flush_survives_drop_oldest) {
+    std::atomic<int> flushes{0};
+    AsyncHandler handler(std::make_unique<SlowHandler>(flushes), 4, OverflowPolicy::DROP_OLDEST);
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t) {
+        producers.emplace_back([&] {
+            while (!stop) {
+                handler.handle(LogLevel::INFO, "record");
+            }
+        });
+    }
+    CHECK(finishesWithin(std::chrono::seconds(30), [&] {
+        for (int i = 0; i < 200; ++i) {
+            handler.flush();
+        }
+    }));
+    stop = true;
+    for (auto& thread : producers) {
+        thread.join();
+    }
+    CHECK(flushes >= 200);
+    CHECK(handler.dropped() > 0);
+}
+
+// FTP-сервер, который принимает соединение, но никогда не отвечает:
+// клиент ждёт приветствия до таймаута операции
+struct SilentServer {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int port = 0;
+    SilentServer() {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        ::bind(fd, reinterpret_cast<sockaddr*>(&address), length);
+        ::listen(fd, 16);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+    }
+    ~SilentServer() {
+        ::close(fd);
+    }
+    std::string address() const {
+        return "127.0.0.1:" + std::to_string(port);
+    }
+};
+
+static std::size_t countFiles(const std::string& directory) {
+    std::size_t count = 0;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        count += entry.is_regular_file() ? 1 : 0;
+    }
+    return count;
+}
+
+// Остановка не ждёт зависшей выгрузки: попытка прерывается, а сегменты
+// остаются в каталоге до следующего запуска
+TEST(ftp_handler_stops_quickly_when_server_hangs) {
+    SilentServer server;
+    test::TempDir dir;
+    std::string spool = dir.file("spool");
+    auto started = std::chrono::steady_clock::now();
+    CHECK(finishesWithin(std::chrono::seconds(60), [&] {
+        FtpHandler handler(server.address(), "/logs/", spool);
+        for (int i = 0; i < 100; ++i) {
+            handler.handle(LogLevel::INFO, "record " + std::to_string(i));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }));
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(3));
+    CHECK(countFiles(spool) > 0);
+}
+
+// Пока сервер недоступен, каталог не растёт больше заданного числа сегментов
+TEST(ftp_handler_caps_spool_segments) {
+    SilentServer server;
+    test::TempDir dir;
+    std::string spool = dir.file("spool");
+    std::size_t discarded = 0;
+    {
+        FtpHandler handler(server.address(), "/logs/", spool, 256, std::chrono::seconds(60),
+                           "anonymous", "logger@", 4);
+        for (int i = 0; i < 2000; ++i) {
+            handler.handle(LogLevel::INFO, "record " + std::to_string(i));
+        }
+        discarded = handler.discardedSegments();
+    }
+    CHECK(discarded > 0);
+    // 4 в очереди, выгружаемый сейчас и текущий
+    CHECK(countFiles(spool) <= 6u);
+}
+
+// UDP-сокет на свободном порту 127.0.0.1; open = false - порт сразу
+// освобождается, и датаграммы на него отклоняются (ECONNREFUSED)
+struct UdpPort {
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    int port = 0;
+    explicit UdpPort(bool open) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        ::bind(fd, reinterpret_cast<sockaddr*>(&address), length);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+        if (!open) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    ~UdpPort() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+// Датаграммы, которые не ушли, считаются потерянными, а не отправленными
+TEST(udp_sender_counts_failed_datagrams_as_dropped) {
+    UdpPort closed(false);
+    BatchedSocketSender sender("127.0.0.1", closed.port, SocketTransport::UDP, 16 * 1024,
+                               std::chrono::milliseconds(5), 64);
+    std::string record(40, 'x');
+    for (int i = 0; i < 50; ++i) {
+        sender.send(record.data(), record.size());
+        sender.flush();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    CHECK_EQ(sender.recordsSent() + sender.recordsDropped(), 50u);
+    CHECK(sender.recordsDropped() > 0);
+    CHECK(sender.recordsSent() < 50u);
+}
+
+// Запись длиннее датаграммы обрезается и учитывается отдельно
+TEST(udp_sender_counts_truncated_records) {
+    UdpPort receiver(true);
+    BatchedSocketSender sender("127.0.0.1", receiver.port, SocketTransport::UDP, 16 * 1024,
+                               std::chrono::milliseconds(5), 1400);
+    std::string big(5000, 'x');
+    std::string small = "small";
+    sender.send(big.data(), big.size());
+    sender.send(small.data(), small.size());
+    sender.flush();
+    CHECK_EQ(sender.recordsTruncated(), 1u);
+    CHECK_EQ(sender.recordsSent(), 2u);
+    char buffer[2048];
+    ssize_t first = ::recv(receiver.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+    CHECK_EQ(first, 1400);
+}
+
+// Пока получатель недоступен, flush() не ждёт окончания задержки перед
+// переподключением: записи остаются в очереди до следующей попытки
+TEST(socket_sender_flush_returns_during_backoff) {
+    int port = SilentServer().port; // порт снова свободен: подключение отклоняется
+    BatchedSocketSender sender("127.0.0.1", port, SocketTransport::TCP, 16 * 1024,
+                               std::chrono::milliseconds(5));
+    auto started = std::chrono::steady_clock::now();
+    CHECK(finishesWithin(std::chrono::seconds(60), [&] {
+        for (int i = 0; i < 12; ++i) {
+            sender.send("record", 6);
+            sender.flush();
+        }
+    }));
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(2));
+    CHECK_EQ(sender.recordsSent(), 0u);
+    CHECK_EQ(sender.recordsDropped(), 0u);
+}
+
+TEST(syslog_sender_flush_returns_during_backoff) {
+    test::TempDir dir;
+    SyslogSender sender(dir.file("missing.sock"), "test", 1, 32, std::chrono::milliseconds(5));
+    auto started = std::chrono::steady_clock::now();
+    CHECK(finishesWithin(std::chrono::seconds(60), [&] {
+        for (int i = 0; i < 12; ++i) {
+            sender.send(SyslogSeverity::INFORMATIONAL, 0, "record", 6);
+            sender.flush();
+        }
+    }));
+    CHECK(std::chrono::steady_clock::now() - started < std::chrono::seconds(2));
+    CHECK_EQ(sender.recordsSent(), 0u);
+}
+
+// Ошибка записи (ENOSPC на /dev/full) не считается записанными байтами,
+// а видна в счётчиках обработчика и в метриках
+TEST(file_handler_reports_write_errors) {
+    if (::access("/dev/full", W_OK) != 0) {
+        return;
+    }
+    Logger logger;
+    auto handler = std::make_unique<FileHandler>("/dev/full", 4096, std::chrono::milliseconds(0));
+    FileHandler& file = *handler;
+    logger.addHandler(std::move(handler));
+    for (int i = 0; i < 100; ++i) {
+        logger.log_info("record " + std::to_string(i));
+    }
+    logger.flush();
+    CHECK_EQ(file.bytesWritten(), 0u);
+    CHECK(file.writeErrors() > 0);
+    CHECK_EQ(file.recordsDropped(), 100u);
+    CHECK_EQ(file.lastWriteError(), ENOSPC);
+    MetricsSnapshot snapshot = logger.metricsSnapshot();
+    CHECK_EQ(snapshot.write_errors, file.writeErrors());
+    CHECK_EQ(snapshot.dropped, 100u);
+    CHECK(snapshot.toText().find("logger_write_errors_total") != std::string::npos);
+}
+
+// В синхронном режиме потоки пишут JSON в один FileHandler одновременно;
+// ни одна строка не должна перемешаться с чужой
+TEST(file_handler_json_lines_survive_concurrent_writers) {
+    test::TempDir dir;
+    std::string path = dir.file("json.log");
+    {
+        Logger logger;
+        auto handler = std::make_unique<FileHandler>(path);
+        handler->setFieldFormat(FieldFormat::JSON);
+        logger.addHandler(std::move(handler));
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; ++t) {
+            writers.emplace_back([&logger, t] {
+                std::string text(200, static_cast<char>('a' + t));
+                for (int i = 0; i < 2000; ++i) {
+                    logger.log_info(text);
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        logger.flush();
+    }
+    std::ifstream in(path);
+    std::string line;
+    std::size_t lines = 0;
+    std::size_t intact = 0;
+    while (std::getline(in, line)) {
+        ++lines;
+        std::size_t start = line.find("\"message\":\"");
+        if (start == std::string::npos || line.size() < start + 11 + 200 + 2) {
+            continue;
+        }
+        std::string text = line.substr(start + 11, 200);
+        if (line.compare(0, 9, "{\"level\":") == 0 &&
+            text == std::string(200, text[0]) &&
+            line.compare(start + 11 + 200, std::string::npos, "\"}") == 0) {
+            ++intact;
+        }
+    }
+    CHECK_EQ(lines, 8000u);
+    CHECK_EQ(intact, lines);
+}
+
+// Заполненные сегменты закрываются хвостом, лишние удаляются, а неполный
+// последний сегмент получает хвост при закрытии обработчика
+TEST(mapped_file_handler_rotates_and_closes_partial_segment) {
+    test::TempDir dir;
+    const std::size_t segment_size = 4096;
+    const std::string record(99, 'r'); // 100 байт со строкой перевода
+    const std::size_t per_segment = (segment_size - sizeof(SegmentFooter)) / 100;
+    const std::size_t total = per_segment * 4 + 7;
+    {
+        MappedFileHandler handler(dir.path().string(), "app", segment_size, 3);
+        for (std::size_t i = 0; i < total; ++i) {
+            handler.handle(LogLevel::INFO, record);
+        }
+        handler.flush();
+    }
+    std::vector<std::string> segments;
+    for (const auto& entry : std::filesystem::directory_iterator(dir.path())) {
+        segments.push_back(entry.path().string());
+    }
+    std::sort(segments.begin(), segments.end());
+    CHECK_EQ(segments.size(), 3u);
+    CHECK(segments.back().find("app.00000004.seg") != std::string::npos);
+
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        SegmentFooter footer{};
+        CHECK(MappedSegmentWriter::readFooter(segments[i], footer));
+        std::size_t expected = i + 1 < segments.size() ? per_segment : 7;
+        CHECK_EQ(footer.record_count, expected);
+        CHECK_EQ(footer.data_bytes, expected * 100);
+        CHECK(footer.first_timestamp_ns <= footer.last_timestamp_ns);
+        CHECK_EQ(std::filesystem::file_size(segments[i]), segment_size);
+
+        std::ifstream in(segments[i], std::ios::binary);
+        std::string data(footer.data_bytes, '\0');
+        in.read(&data[0], static_cast<std::streamsize>(data.size()));
+        std::string lines;
+        for (std::size_t n = 0; n < expected; ++n) {
+            lines += record + "\n";
+        }
+        CHECK(data == lines);
+    }
+}
+
+// Всё, что уже лежит в канале или на ведущей стороне псевдотерминала
+static std::string readAvailable(int fd) {
+    int flags = ::fcntl(fd, F_GETFL);
+    ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    std::string data;
+    char chunk[4096];
+    for (;;) {
+        ssize_t got = ::read(fd, chunk, sizeof(chunk));
+        if (got <= 0) {
+            break;
+        }
+        data.append(chunk, static_cast<std::size_t>(got));
+    }
+    ::fcntl(fd, F_SETFL, flags);
+    return data;
+}
+
+// Строки, добавленные в течение интервала, уходят одним write(2);
+// на канал (не терминал) цвет не выводится
+TEST(console_writer_writes_once_per_interval) {
+    int pipe_fds[2];
+    CHECK_EQ(::pipe(pipe_fds), 0);
+    std::string expected;
+    {
+        ConsoleWriter writer(pipe_fds[1], std::chrono::milliseconds(300));
+        CHECK(!writer.colored());
+        for (int i = 0; i < 100; ++i) {
+            std::string line = "line " + std::to_string(i);
+            writer.append("\033[31m", line.data(), line.size());
+            expected += line + "\n";
+        }
+        CHECK_EQ(writer.writeCalls(), 0u);
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (writer.writeCalls() == 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        CHECK_EQ(writer.writeCalls(), 1u);
+        CHECK_EQ(writer.bytesWritten(), expected.size());
+    }
+    CHECK(readAvailable(pipe_fds[0]) == expected);
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+}
+
+// Набравшийся buffer_size сбрасывается сразу, не дожидаясь интервала
+TEST(console_writer_flushes_full_buffer) {
+    int pipe_fds[2];
+    CHECK_EQ(::pipe(pipe_fds), 0);
+    {
+        ConsoleWriter writer(pipe_fds[1], std::chrono::seconds(60), 1024);
+        std::string line(100, 'x'); // 101 байт со строкой перевода
+        for (int i = 0; i < 10; ++i) {
+            writer.append("", line.data(), line.size());
+        }
+        CHECK_EQ(writer.writeCalls(), 0u);
+        writer.append("", line.data(), line.size());
+        CHECK_EQ(writer.writeCalls(), 1u);
+        CHECK_EQ(readAvailable(pipe_fds[0]).size(), 11u * 101u);
+    }
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+}
+
+// На терминале подряд идущие строки одного цвета идут под одной
+// escape-последовательностью, серия закрывается сбросом цвета
+TEST(console_writer_coalesces_color_runs) {
+    int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || ::grantpt(master) != 0 || ::unlockpt(master) != 0) {
+        return; // псевдотерминалы недоступны
+    }
+    int slave = ::open(::ptsname(master), O_RDWR | O_NOCTTY);
+    CHECK(slave >= 0);
+    termios mode{};
+    ::tcgetattr(slave, &mode);
+    ::cfmakeraw(&mode); // без замены \n на \r\n
+    ::tcsetattr(slave, TCSANOW, &mode);
+    {
+        ConsoleWriter writer(slave, std::chrono::seconds(60));
+        CHECK(writer.colored());
+        writer.append("\033[31m", "a", 1);
+        writer.append("\033[31m", "b", 1);
+        writer.append("\033[32m", "c", 1);
+        writer.append("", "d", 1);
+        writer.flush();
+        CHECK_EQ(writer.writeCalls(), 1u);
+    }
+    std::string expected = "\033[31ma\nb\n\033[0m\033[32mc\n\033[0md\n";
+    std::string actual;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (actual.size() < expected.size() && std::chrono::steady_clock::now() < deadline) {
+        actual += readAvailable(master);
+    }
+    CHECK(actual == expected);
+    ::close(slave);
+    ::close(master);
+}
+
+enum class Shade : int {
+    DARK = 3
+};
+
+// LOGF_* подставляют аргумент каждого поддерживаемого типа так же,
+// как описано в format_string.hpp
+TEST(logf_formats_each_argument_type) {
+    std::vector<std::string> lines;
+    Logger logger;
+    logger.addHandler(std::make_unique<CaptureHandler>(lines));
+    logger.setModuleLevel("root", LogLevel::INFO);
+    const char* name = "db";
+    const char* missing = nullptr;
+    std::string owned = "owned";
+    std::string_view view = "view";
+    void* address = reinterpret_cast<void*>(std::uintptr_t(0x1f00));
+    signed char small = -5;
+
+    LOGF_INFO(logger, "int {} {} {}", 42, -7, 18446744073709551615ull);
+    LOGF_INFO(logger, "dec {:d} hex {:x} {:x}", 255, 255, -1);
+    LOGF_INFO(logger, "bool {} {} char {} small {}", true, false, 'z', small);
+    LOGF_INFO(logger, "enum {} {:d}", Shade::DARK, Shade::DARK);
+    LOGF_INFO(logger, "str {} {:s} {} {} {}", name, "literal", owned, view, missing);
+    LOGF_INFO(logger, "float {} {} {:.2f} {:.0f}", 0.1, 2.5f, 3.14159, 2.5);
+    LOGF_INFO(logger, "ptr {} {:x}", address, address);
+    LOGF_INFO(logger, "braces {{}} {{{}}}", 1);
+    LOGF_WARN(logger, "no arguments");
+    LOGF_DEBUG(logger, "below level {}", 1);
+
+    const std::vector<std::string> expected = {
+        "int 42 -7 18446744073709551615",
+        "dec 255 hex ff ffffffff",
+        "bool true false char z small -5",
+        "enum 3 3",
+        "str db literal owned view (null)",
+        "float 0.1 2.5 3.14 2",
+        "ptr 0x1f00 0x1f00",
+        "braces {} {1}",
+        "no arguments",
+    };
+    CHECK_EQ(lines.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size() && i < lines.size(); ++i) {
+        if (lines[i] != expected[i]) {
+            std::printf("  got \"%s\", expected \"%s\"\n", lines[i].c_str(), expected[i].c_str());
+        }
+        CHECK(lines[i] == expected[i]);
+    }
+}
+
+TEST_MAIN()
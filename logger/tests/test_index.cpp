@@ -0,0 +1,109 @@
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "logger.hpp"
+#include "test_util.hpp"
+
+static std::uint64_t fileSize(const std::string& path) {
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+}
+
+static ino_t inodeOf(const std::string& path) {
+    struct stat info;
+    return ::stat(path.c_str(), &info) == 0 ? info.st_ino : 0;
+}
+
+static bool sameEntries(const std::vector<LogIndexEntry>& a, const std::vector<LogIndexEntry>& b) {
+    return a.size() == b.size() &&
+           (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(LogIndexEntry)) == 0);
+}
+
+// Живой индекс в любой момент описывает только байты, уже лежащие в файле,
+// а после закрытия совпадает с построенным заново
+TEST(live_index_never_runs_past_file) {
+    test::TempDir dir;
+    std::string path = dir.file("app.log");
+    bool within_file = true;
+    bool contiguous = true;
+    {
+        Logger logger;
+        logger.addFormatter(std::make_unique<TimestampFormatter>());
+        auto handler = std::make_unique<FileHandler>(path, 64 * 1024, std::chrono::milliseconds(5));
+        handler->enableIndex(4096);
+        logger.addHandler(std::move(handler));
+        for (int i = 0; i < 60000; ++i) {
+            logger.log(i % 50 == 0 ? LogLevel::ERROR : LogLevel::INFO, "record " + std::to_string(i));
+            if (i % 5000 == 4999) {
+                std::vector<LogIndexEntry> entries;
+                LogIndexBuilder::read(path + ".idx", entries);
+                std::uint64_t end = 0;
+                for (const auto& entry : entries) {
+                    contiguous = contiguous && entry.offset == end;
+                    end = entry.offset + entry.size;
+                }
+                within_file = within_file && end <= fileSize(path);
+            }
+        }
+    }
+    CHECK(within_file);
+    CHECK(contiguous);
+
+    std::vector<LogIndexEntry> live;
+    CHECK(LogIndexBuilder::read(path + ".idx", live));
+    std::string copy = dir.file("copy.log");
+    std::filesystem::copy_file(path, copy);
+    {
+        LogIndexBuilder rebuilt(4096);
+        CHECK(rebuilt.attach(copy, copy + ".idx"));
+    }
+    std::vector<LogIndexEntry> offline;
+    CHECK(LogIndexBuilder::read(copy + ".idx", offline));
+    CHECK(sameEntries(live, offline));
+}
+
+// log_query читает индекс работающего FileHandler, но не трогает его:
+// файл индекса остаётся тем же, и FileHandler продолжает его дописывать
+TEST(log_query_leaves_live_index_alone) {
+    test::TempDir dir;
+    std::string path = dir.file("app.log");
+    Logger logger;
+    logger.addFormatter(std::make_unique<TimestampFormatter>());
+    auto handler = std::make_unique<FileHandler>(path, 64 * 1024, std::chrono::seconds(60));
+    handler->enableIndex(4096);
+    logger.addHandler(std::move(handler));
+    std::string command = std::string(LOG_QUERY) + " " + path + " --level ERROR > " + dir.file("out.txt");
+    ino_t inode = 0;
+    bool same_inode = true;
+    for (int i = 0; i < 40000; ++i) {
+        logger.log(i % 100 == 0 ? LogLevel::ERROR : LogLevel::INFO, "record " + std::to_string(i));
+        if (i % 8000 == 7999) {
+            CHECK_EQ(std::system(command.c_str()), 0);
+            ino_t current = inodeOf(path + ".idx");
+            same_inode = same_inode && (inode == 0 || current == inode);
+            inode = current;
+        }
+    }
+    logger.flush();
+    CHECK(same_inode);
+    std::vector<LogIndexEntry> entries;
+    CHECK(LogIndexBuilder::read(path + ".idx", entries));
+    std::uint64_t indexed = entries.empty() ? 0 : entries.back().offset + entries.back().size;
+    CHECK(indexed + 4096 * 2 >= fileSize(path));
+
+    CHECK_EQ(std::system(command.c_str()), 0);
+    std::ifstream out(dir.file("out.txt"));
+    int lines = 0;
+    for (std::string line; std::getline(out, line);) {
+        lines += line.find("[ERROR]") == 0 ? 1 : 0;
+    }
+    CHECK_EQ(lines, 400);
+}
+
+TEST_MAIN()
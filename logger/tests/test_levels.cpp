@@ -0,0 +1,42 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "capture_handler.hpp"
+#include "logger.hpp"
+#include "test_util.hpp"
+
+// Уровень root - общий порог, но модуль с DEBUG пишет отладочные записи
+TEST(module_debug_passes_root_info) {
+    std::vector<std::string> lines;
+    Logger logger;
+    logger.addHandler(std::make_unique<CaptureHandler>(lines));
+    logger.setModuleLevel("root", LogLevel::INFO);
+    logger.setModuleLevel("net.http", LogLevel::DEBUG);
+    ModuleLogger& http = logger.getLogger("net.http");
+    ModuleLogger& db = logger.getLogger("db");
+
+    logger.log_debug("root debug");
+    db.log_debug("db debug");
+    http.log_debug("http debug");
+    http.child("client").log_debug("client debug");
+    logger.log_info("root info");
+
+    CHECK_EQ(lines.size(), 3u);
+    CHECK(lines.size() == 3 && lines[0] == "[net.http] http debug");
+    CHECK(lines.size() == 3 && lines[1] == "[net.http.client] client debug");
+    CHECK(lines.size() == 3 && lines[2] == "root info");
+}
+
+// LevelFilter проверяет все записи: вместе с уровнями модулей он отсекает DEBUG
+TEST(level_filter_also_gates_modules) {
+    std::vector<std::string> lines;
+    Logger logger;
+    logger.addHandler(std::make_unique<CaptureHandler>(lines));
+    logger.addFilter(std::make_unique<LevelFilter>(LogLevel::INFO));
+    logger.setModuleLevel("net.http", LogLevel::DEBUG);
+    logger.getLogger("net.http").log_debug("http debug");
+    CHECK(lines.empty());
+}
+
+TEST_MAIN()
@@ -0,0 +1,86 @@
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "aho_corasick.hpp"
+#include "regex_engine.hpp"
+#include "substring_search.hpp"
+#include "test_util.hpp"
+
+static std::string randomText(std::mt19937& random, std::size_t size, const char* alphabet) {
+    std::string text;
+    std::size_t letters = std::char_traits<char>::length(alphabet);
+    for (std::size_t i = 0; i < size; ++i) {
+        text += alphabet[random() % letters];
+    }
+    return text;
+}
+
+// Результаты CompiledRegex совпадают с std::regex_search
+TEST(regex_matches_std_regex) {
+    const std::vector<std::string> patterns = {
+        "abc", "a.c", "^ab", "bc$", "a*b+c?", "(ab|ba)+", "[a-c]{2,3}", "[^ab]c",
+        "^(a|b)*$", "error|warn", "c(a|b)*c", "\\d+", "a.*b.*c",
+    };
+    std::mt19937 random(7);
+    for (const auto& pattern : patterns) {
+        CompiledRegex compiled(pattern);
+        std::regex reference(pattern, std::regex::ECMAScript);
+        bool same = true;
+        for (int i = 0; i < 500; ++i) {
+            std::string text = randomText(random, random() % 24, "abc123 ");
+            if (i % 50 == 0) {
+                text += " error ";
+            }
+            same = same && compiled.search(text) == std::regex_search(text, reference);
+        }
+        if (!same) {
+            std::printf("  pattern %s differs from std::regex\n", pattern.c_str());
+        }
+        CHECK(same);
+    }
+}
+
+// containsAny/containsAll совпадают с наивным поиском каждого образца
+TEST(aho_corasick_matches_naive_search) {
+    std::mt19937 random(11);
+    for (int round = 0; round < 200; ++round) {
+        std::vector<std::string> patterns;
+        for (int i = 0, count = 1 + random() % 5; i < count; ++i) {
+            patterns.push_back(randomText(random, 1 + random() % 4, "abcd"));
+        }
+        AhoCorasick automaton(patterns);
+        for (int i = 0; i < 20; ++i) {
+            std::string text = randomText(random, random() % 40, "abcde");
+            bool any = false;
+            bool all = true;
+            for (const auto& pattern : patterns) {
+                bool found = text.find(pattern) != std::string::npos;
+                any = any || found;
+                all = all && found;
+            }
+            CHECK_EQ(automaton.containsAny(text), any);
+            CHECK_EQ(automaton.containsAll(text), all);
+        }
+    }
+}
+
+// Все поддерживаемые ядра находят то же вхождение, что std::string::find,
+// в том числе у конца буфера
+TEST(substring_kernels_match_find) {
+    std::mt19937 random(3);
+    for (SearchKernel kind : {SearchKernel::SCALAR, SearchKernel::SSE2, SearchKernel::AVX2}) {
+        if (!SubstringSearcher::isSupported(kind)) {
+            continue;
+        }
+        for (int round = 0; round < 2000; ++round) {
+            std::string needle = randomText(random, 1 + random() % 6, "ab");
+            std::string text = randomText(random, random() % 100, "abc");
+            SubstringSearcher searcher(needle, kind);
+            CHECK_EQ(searcher.find(text), text.find(needle));
+        }
+    }
+}
+
+TEST_MAIN()
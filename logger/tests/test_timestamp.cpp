@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "timestamp_engine.hpp"
+#include "test_util.hpp"
+
+static std::int64_t systemNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Часы TSC сверяются с system_clock и не уходят от них, а время в каждом
+// потоке не идёт назад
+TEST(tsc_clock_follows_system_clock) {
+    TimestampEngine engine(TimestampPrecision::NANO, ClockSource::TSC);
+    if (engine.clock() != ClockSource::TSC) {
+        return; // на этой платформе TSC нет
+    }
+    std::vector<std::thread> threads;
+    std::vector<int> backwards(4, 0);
+    std::vector<std::int64_t> worst(4, 0);
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&engine, &backwards, &worst, t] {
+            auto stop = std::chrono::steady_clock::now() + std::chrono::milliseconds(2500);
+            std::int64_t previous = 0;
+            while (std::chrono::steady_clock::now() < stop) {
+                std::int64_t stamp = engine.now();
+                backwards[t] += stamp < previous ? 1 : 0;
+                previous = stamp;
+                std::int64_t error = std::llabs(stamp - systemNs());
+                worst[t] = error > worst[t] ? error : worst[t];
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < 4; ++t) {
+        CHECK_EQ(backwards[t], 0);
+        CHECK(worst[t] < 5000000); // 5 мс
+    }
+}
+
+TEST(system_clock_matches_system_clock) {
+    TimestampEngine engine;
+    CHECK(engine.clock() == ClockSource::SYSTEM);
+    CHECK(std::llabs(engine.now() - systemNs()) < 5000000);
+}
+
+TEST_MAIN()
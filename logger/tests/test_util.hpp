@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+// Минимальный набор для тестов без внешних зависимостей: каждый тест -
+// функция, CHECK при ошибке печатает условие и продолжает, код возврата
+// main - число упавших тестов
+namespace test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline std::vector<std::pair<const char*, std::function<void()>>>& registry() {
+    static std::vector<std::pair<const char*, std::function<void()>>> tests;
+    return tests;
+}
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> body) {
+        registry().emplace_back(name, std::move(body));
+    }
+};
+
+// Временный каталог теста, удаляется вместе с содержимым
+class TempDir {
+private:
+    std::filesystem::path path_;
+
+public:
+    TempDir() {
+        std::string pattern = (std::filesystem::temp_directory_path() / "logger_test.XXXXXX").string();
+        if (::mkdtemp(pattern.data()) != nullptr) {
+            path_ = pattern;
+        }
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    ~TempDir() {
+        std::error_code error;
+        std::filesystem::remove_all(path_, error);
+    }
+
+    std::string file(const std::string& name) const {
+        return (path_ / name).string();
+    }
+
+    const std::filesystem::path& path() const {
+        return path_;
+    }
+};
+
+inline int runAll() {
+    int failed_tests = 0;
+    for (const auto& [name, body] : registry()) {
+        int before = failures();
+        body();
+        bool passed = failures() == before;
+        failed_tests += passed ? 0 : 1;
+        std::printf("%s %s\n", passed ? "[ OK ]" : "[FAIL]", name);
+    }
+    return failed_tests;
+}
+
+} // namespace test
+
+#define TEST_CONCAT_INNER(a, b) a##b
+#define TEST_CONCAT(a, b) TEST_CONCAT_INNER(a, b)
+
+#define TEST(name)                                                                   \
+    static void name();                                                              \
+    static test::Registrar TEST_CONCAT(name, _registrar)(#name, &name);              \
+    static void name()
+
+#define CHECK(condition)                                                             \
+    do {                                                                             \
+        if (!(condition)) {                                                          \
+            std::printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            ++test::failures();                                                      \
+        }                                                                            \
+    } while (false)
+
+#define CHECK_EQ(actual, expected)                                                   \
+    do {                                                                             \
+        auto test_actual_ = (actual);                                                \
+        auto test_expected_ = (expected);                                            \
+        if (!(test_actual_ == test_expected_)) {                                     \
+            std::printf("  %s:%d: CHECK_EQ(%s, %s) failed: %s vs %s\n", __FILE__, __LINE__, \
+                        #actual, #expected, std::to_string(test_actual_).c_str(),    \
+                        std::to_string(test_expected_).c_str());                     \
+            ++test::failures();                                                      \
+        }                                                                            \
+    } while (false)
+
+#define TEST_MAIN()                                                                  \
+    int main() {                                                                     \
+        return test::runAll();                                                       \
+    }
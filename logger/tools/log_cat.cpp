@@ -0,0 +1,28 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "lz_codec.hpp"
+
+// Печатает содержимое сжатых логов (<файл>.lz) в stdout,
+// распаковывая их потоково: log_cat app.log.1710000000000.lz | grep ERROR
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <file.lz>..." << std::endl;
+        return 2;
+    }
+
+    int status = 0;
+    char buffer[64 * 1024];
+    for (int i = 1; i < argc; ++i) {
+        LzFileReader reader(argv[i]);
+        std::size_t read;
+        while ((read = reader.read(buffer, sizeof(buffer))) > 0) {
+            std::fwrite(buffer, 1, read, stdout);
+        }
+        if (!reader.good()) {
+            std::cerr << argv[i] << ": not a compressed log or file is corrupted" << std::endl;
+            status = 1;
+        }
+    }
+    return status;
+}
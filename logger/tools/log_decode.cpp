@@ -0,0 +1,40 @@
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "binary_log.hpp"
+#include "timestamp_engine.hpp"
+
+// Восстанавливает текст двоичного журнала отложенного форматирования
+// (Logger::enableBinaryLog) в виде строк TimestampFormatter:
+//   log_decode app.blog [app.blog.fmt]
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " <file.blog> [format-table]" << std::endl;
+        return 2;
+    }
+    std::string path = argv[1];
+    BinaryLogReader reader(path, argc > 2 ? argv[2] : path + ".fmt");
+    if (!reader.good()) {
+        std::cerr << path << ": not a binary log" << std::endl;
+        return 1;
+    }
+
+    static const char* const level_names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    TimestampEngine engine;
+    char stamp[TimestampEngine::MaxLength];
+    BinaryRecordHeader header;
+    std::string text;
+    std::string line;
+    while (reader.next(header, text)) {
+        line.assign("[");
+        line += header.level < 4 ? level_names[header.level] : "UNKNOWN";
+        line += "] [";
+        line.append(stamp, engine.render(header.timestamp_ns, stamp));
+        line += "] ";
+        line += text;
+        line += '\n';
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+    return 0;
+}
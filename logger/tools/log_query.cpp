@@ -0,0 +1,152 @@
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "log_index.hpp"
+
+// Выборка строк журнала FileHandler по времени и уровню с помощью
+// разреженного индекса <файл>.idx (FileHandler::enableIndex):
+//   log_query app.log --from "2024.05.01 13:00" --to "2024.05.01 14:00" --level ERROR
+// --level: список через запятую (WARN,ERROR) или уровень и выше (WARN+).
+// --from включительно, --to - нет. Файл отображается в память, читаются только
+// блоки, подходящие по индексу. Существующий индекс (его может дописывать
+// работающий FileHandler) только читается: годная часть используется, блоки
+// за концом файла обрезаются, остальное просматривается целиком. Если индекса
+// нет, он строится. --rebuild - построить индекс заново (не при работающем
+// FileHandler), --stats - сколько прочитано (в stderr)
+static bool parseLevels(const std::string& text, unsigned& mask) {
+    mask = 0;
+    std::size_t start = 0;
+    while (start <= text.size()) {
+        std::size_t comma = text.find(',', start);
+        std::string name = text.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        bool and_above = !name.empty() && name.back() == '+';
+        if (and_above) {
+            name.pop_back();
+        }
+        int level = LogLineParser::levelFromName(name);
+        if (level == LogLineParser::UnknownLevel) {
+            return false;
+        }
+        for (int i = level; i <= (and_above ? 3 : level); ++i) {
+            mask |= 1u << i;
+        }
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0]
+                  << " <file.log> [--from TIME] [--to TIME] [--level LIST] [--rebuild] [--stats]" << std::endl;
+        return 2;
+    }
+    std::string path = argv[1];
+    std::string index_path = path + ".idx";
+    std::int64_t from_ms = std::numeric_limits<std::int64_t>::min();
+    std::int64_t to_ms = std::numeric_limits<std::int64_t>::max();
+    unsigned mask = 0xFF;
+    bool rebuild = false;
+    bool stats = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string option = argv[i];
+        bool has_value = i + 1 < argc;
+        if (option == "--from" && has_value && LogLineParser::parseTime(argv[i + 1], from_ms)) {
+            ++i;
+        } else if (option == "--to" && has_value && LogLineParser::parseTime(argv[i + 1], to_ms)) {
+            ++i;
+        } else if (option == "--level" && has_value && parseLevels(argv[i + 1], mask)) {
+            ++i;
+        } else if (option == "--rebuild") {
+            rebuild = true;
+        } else if (option == "--stats") {
+            stats = true;
+        } else {
+            std::cerr << "bad option: " << option << std::endl;
+            return 2;
+        }
+    }
+
+    MappedLogFile log(path);
+    if (!log.good()) {
+        std::cerr << path << ": cannot open" << std::endl;
+        return 1;
+    }
+
+    std::vector<LogIndexEntry> entries;
+    if (rebuild || ::access(index_path.c_str(), F_OK) != 0) {
+        if (rebuild) {
+            ::unlink(index_path.c_str());
+        }
+        LogIndexBuilder builder;
+        if (!builder.attach(path, index_path)) {
+            std::cerr << index_path << ": cannot write index" << std::endl;
+            return 1;
+        }
+    }
+    // Индекс, который пишет работающий FileHandler, только читается: берутся
+    // блоки, идущие подряд с начала файла, последний обрезается по размеру файла
+    std::vector<LogIndexEntry> indexed;
+    std::uint64_t indexed_end = 0;
+    LogIndexBuilder::read(index_path, indexed);
+    for (auto entry : indexed) {
+        if (entry.offset != indexed_end || entry.offset >= log.size()) {
+            break;
+        }
+        if (entry.offset + entry.size > log.size()) {
+            entry.size = static_cast<std::uint32_t>(log.size() - entry.offset);
+        }
+        indexed_end = entry.offset + entry.size;
+        entries.push_back(entry);
+    }
+    // Хвост без индекса - как один блок, подходящий под любой запрос
+    if (indexed_end < log.size()) {
+        LogIndexEntry tail;
+        tail.offset = indexed_end;
+        tail.size = static_cast<std::uint32_t>(log.size() - indexed_end);
+        tail.first_ms = std::numeric_limits<std::int64_t>::min();
+        tail.last_ms = std::numeric_limits<std::int64_t>::max();
+        tail.levels = 0xFF;
+        entries.push_back(tail);
+    }
+
+    LogLineParser parser;
+    std::uint64_t blocks = 0;
+    std::uint64_t scanned = 0;
+    std::uint64_t matched = 0;
+    unsigned block_mask = mask | (1u << LogLineParser::UnknownLevel);
+    for (const auto& entry : entries) {
+        if (entry.last_ms < from_ms || entry.first_ms >= to_ms || (entry.levels & block_mask) == 0) {
+            continue;
+        }
+        ++blocks;
+        scanned += entry.size;
+        log.prefetch(entry.offset, entry.size);
+        // Строки без заголовка (продолжения) относятся к предыдущей записи
+        int level = LogLineParser::UnknownLevel;
+        std::int64_t ms = entry.first_ms;
+        log.forEachLine(entry.offset, entry.size, [&](const char* line, std::size_t size) {
+            parser.parse(line, size, level, ms);
+            if (ms >= from_ms && ms < to_ms && (mask & (1u << level)) != 0) {
+                std::fwrite(line, 1, size, stdout);
+                std::fputc('\n', stdout);
+                ++matched;
+            }
+        });
+    }
+    std::fflush(stdout);
+    if (stats) {
+        std::cerr << "blocks " << blocks << "/" << entries.size() << ", scanned " << scanned << " of "
+                  << log.size() << " bytes, " << matched << " lines" << std::endl;
+    }
+    return 0;
+}
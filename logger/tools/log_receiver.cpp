@@ -0,0 +1,177 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Приёмник для проверки SocketHandler и SyslogHandler на одной машине.
+// Считает записи и байты, раз в секунду печатает скорость, а после
+// idle_seconds без данных печатает итог и завершается.
+//   log_receiver udp 5140 [idle_seconds] [--print]
+//   log_receiver tcp 5140 [idle_seconds] [--print]
+//   log_receiver unix /tmp/test.sock [idle_seconds] [--print]  (датаграмма = запись)
+
+struct Stats {
+    std::uint64_t records = 0;
+    std::uint64_t bytes = 0;
+};
+
+static void countLines(const char* data, std::size_t size, Stats& stats, bool print) {
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+        if (data[i] == '\n') {
+            if (print) {
+                std::fwrite(data + start, 1, i - start + 1, stdout);
+            }
+            ++stats.records;
+            start = i + 1;
+        }
+    }
+    stats.bytes += size;
+}
+
+// Разбирает кадры [uint32 длина, big-endian][запись] из накопленного буфера
+static void consumeFrames(std::string& buffer, Stats& stats, bool print) {
+    std::size_t offset = 0;
+    while (buffer.size() - offset >= 4) {
+        const auto* p = reinterpret_cast<const unsigned char*>(buffer.data() + offset);
+        std::uint32_t length = (std::uint32_t(p[0]) << 24) | (std::uint32_t(p[1]) << 16) |
+                               (std::uint32_t(p[2]) << 8) | std::uint32_t(p[3]);
+        if (buffer.size() - offset - 4 < length) {
+            break;
+        }
+        if (print) {
+            std::fwrite(buffer.data() + offset + 4, 1, length, stdout);
+            std::fputc('\n', stdout);
+        }
+        ++stats.records;
+        stats.bytes += length + 4;
+        offset += 4 + length;
+    }
+    buffer.erase(0, offset);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " udp|tcp <port> | unix <path> [idle_seconds] [--print]" << std::endl;
+        return 2;
+    }
+    bool tcp = std::strcmp(argv[1], "tcp") == 0;
+    bool unix_socket = std::strcmp(argv[1], "unix") == 0;
+    int idle_seconds = argc > 3 && argv[3][0] != '-' ? std::atoi(argv[3]) : 5;
+    bool print = std::strcmp(argv[argc - 1], "--print") == 0;
+
+    int listener = -1;
+    int bound = -1;
+    if (unix_socket) {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, argv[2], sizeof(address.sun_path) - 1);
+        ::unlink(address.sun_path);
+        listener = ::socket(AF_UNIX, SOCK_DGRAM, 0);
+        bound = ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    } else {
+        listener = ::socket(AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+        int one = 1;
+        ::setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(static_cast<std::uint16_t>(std::atoi(argv[2])));
+        bound = ::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    }
+    int receive_buffer = 8 * 1024 * 1024;
+    ::setsockopt(listener, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+    if (bound != 0 || (tcp && ::listen(listener, 16) != 0)) {
+        std::perror("bind/listen");
+        return 1;
+    }
+
+    std::vector<pollfd> fds{{listener, POLLIN, 0}};
+    std::vector<std::string> buffers{std::string()};
+    std::vector<char> chunk(1 << 16);
+    Stats total;
+    Stats last_report;
+    auto started = std::chrono::steady_clock::now();
+    auto last_data = started;
+    auto last_print = started;
+    bool received_any = false;
+
+    for (;;) {
+        int ready = ::poll(fds.data(), fds.size(), 200);
+        auto now = std::chrono::steady_clock::now();
+        if (ready > 0) {
+            for (std::size_t i = 0; i < fds.size(); ++i) {
+                if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                    continue;
+                }
+                if (tcp && i == 0) {
+                    int client = ::accept(listener, nullptr, nullptr);
+                    if (client >= 0) {
+                        fds.push_back({client, POLLIN, 0});
+                        buffers.emplace_back();
+                    }
+                    continue;
+                }
+                ssize_t received = ::recv(fds[i].fd, chunk.data(), chunk.size(), 0);
+                if (received <= 0) {
+                    if (tcp) {
+                        ::close(fds[i].fd);
+                        fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i));
+                        buffers.erase(buffers.begin() + static_cast<std::ptrdiff_t>(i));
+                        --i;
+                    }
+                    continue;
+                }
+                if (!received_any) {
+                    started = now;
+                    received_any = true;
+                }
+                last_data = now;
+                if (tcp) {
+                    buffers[i].append(chunk.data(), static_cast<std::size_t>(received));
+                    consumeFrames(buffers[i], total, print);
+                } else if (unix_socket) {
+                    if (print) {
+                        std::fwrite(chunk.data(), 1, static_cast<std::size_t>(received), stdout);
+                        std::fputc('\n', stdout);
+                    }
+                    ++total.records;
+                    total.bytes += static_cast<std::size_t>(received);
+                } else {
+                    countLines(chunk.data(), static_cast<std::size_t>(received), total, print);
+                }
+            }
+        }
+
+        if (!print && now - last_print >= std::chrono::seconds(1)) {
+            double seconds = std::chrono::duration<double>(now - last_print).count();
+            if (total.records != last_report.records) {
+                std::cerr << "records/s: " << static_cast<std::uint64_t>((total.records - last_report.records) / seconds)
+                          << "  MB/s: " << (total.bytes - last_report.bytes) / seconds / 1e6 << std::endl;
+            }
+            last_report = total;
+            last_print = now;
+        }
+        if (received_any && now - last_data >= std::chrono::seconds(idle_seconds)) {
+            break;
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(last_data - started).count();
+    std::cerr << "total records: " << total.records << "  bytes: " << total.bytes
+              << "  seconds: " << seconds << std::endl;
+    if (unix_socket) {
+        ::unlink(argv[2]);
+    }
+    return 0;
+}